@@ -7,8 +7,12 @@
 #include <lunaix/isrm.h>
 #include <lunaix/spike.h>
 
+#include <sys/cpu.h>
 #include <sys/i386_intr.h>
 #include <sys/interrupts.h>
+#include <sys/x86_isa.h>
+
+#include <cpuid.h>
 
 void
 exception_init()
@@ -21,12 +25,33 @@ exception_init()
 extern void
 syscall_hndlr(const isr_param* param);
 
+extern void
+sysenter_entry();
+
+extern u8_t sysenter_stack[];
+
+static void
+sysenter_init()
+{
+    u32_t eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & CPUID_FEAT_SEP)) {
+        return;
+    }
+
+    // sysexit takes user cs and ss at +16 and +24 from it
+    cpu_wrmsr(IA32_MSR_SYSENTER_CS, 0, KCODE_SEG);
+    cpu_wrmsr(IA32_MSR_SYSENTER_ESP, 0, (u32_t)sysenter_stack);
+    cpu_wrmsr(IA32_MSR_SYSENTER_EIP, 0, (u32_t)sysenter_entry);
+}
+
 void
 arch_preinit()
 {
     exception_init();
 
     isrm_bindiv(LUNAIX_SYS_CALL, syscall_hndlr);
+    sysenter_init();
 }
 
 struct hwtimer*
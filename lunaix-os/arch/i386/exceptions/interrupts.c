@@ -54,4 +54,25 @@ done:
     }
 
     return;
-}
\ No newline at end of file
+}
+
+extern void
+syscall_hndlr(const isr_param* param);
+
+/**
+ * @brief Syscall made by sysenter, param is built by sysenter_entry
+ * except the user return address.
+ */
+void
+sysenter_handler(isr_param* param)
+{
+    ptr_t ustack = param->execp->esp;
+
+    update_thread_context(param);
+    current_thread->ustack_top = ustack;
+
+    // libc stub leaves the return address on top of its stack
+    param->execp->eip = kernel_addr(ustack) ? 0 : *(ptr_t*)ustack;
+
+    syscall_hndlr(param);
+}
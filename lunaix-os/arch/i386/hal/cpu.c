@@ -2,6 +2,7 @@
 #include <lunaix/types.h>
 #include <sys/cpu.h>
 #include <sys/vectors.h>
+#include <sys/x86_isa.h>
 
 #define BRAND_LEAF 0x80000000UL
 
@@ -62,6 +63,14 @@ cpu_wrmsr(u32_t msr_idx, u32_t reg_high, u32_t reg_low)
     asm volatile("wrmsr" : : "d"(reg_high), "a"(reg_low), "c"(msr_idx));
 }
 
+bool
+cpu_has_cycles()
+{
+    u32_t eax, ebx, ecx, edx;
+
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & CPUID_FEAT_TSC);
+}
+
 void
 cpu_trap_sched()
 {
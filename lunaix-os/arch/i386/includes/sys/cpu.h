@@ -11,6 +11,19 @@
 void
 cpu_get_id(char* id_out);
 
+void
+cpu_rdmsr(u32_t msr_idx, u32_t* reg_high, u32_t* reg_low);
+
+void
+cpu_wrmsr(u32_t msr_idx, u32_t reg_high, u32_t reg_low);
+
+/**
+ * @brief Whether the processor has a cycle counter for cpu_cycles
+ *
+ */
+bool
+cpu_has_cycles();
+
 void
 cpu_trap_sched();
 
@@ -80,12 +93,70 @@ cpu_disable_interrupt()
     asm volatile("cli");
 }
 
+/**
+ * @brief Disable interrupt, return the previous interrupt state
+ *        to be restored later with cpu_restore_interrupt
+ *
+ * @return u32_t
+ */
+static inline u32_t
+cpu_save_interrupt()
+{
+    u32_t state = cpu_ldstate() & 0x200;
+    cpu_disable_interrupt();
+    return state;
+}
+
+static inline void
+cpu_restore_interrupt(u32_t state)
+{
+    if (state) {
+        cpu_enable_interrupt();
+    }
+}
+
+/**
+ * @brief Id of the executing cpu. Lunaix does not bring up the APs
+ *        yet, thus always the BSP.
+ *
+ */
+static inline u32_t
+cpu_id()
+{
+    return 0;
+}
+
 static inline void
 cpu_wait()
 {
     asm("hlt");
 }
 
+/**
+ * @brief Enable interrupt and halt until next interrupt arrive.
+ *        sti takes effect after hlt, so nothing can sneak in between.
+ *
+ */
+static inline void
+cpu_idle()
+{
+    asm volatile("sti\n"
+                 "hlt");
+}
+
+/**
+ * @brief Read the free running cycle counter (TSC)
+ *
+ * @return u64_t
+ */
+static inline u64_t
+cpu_cycles()
+{
+    u64_t val;
+    asm volatile("rdtsc" : "=A"(val));
+    return val;
+}
+
 /**
  * @brief Read exeception address
  *
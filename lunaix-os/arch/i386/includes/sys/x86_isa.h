@@ -9,6 +9,13 @@
 
 #define tss_esp0_off 4
 
+#define CPUID_FEAT_TSC (1 << 4)
+#define CPUID_FEAT_SEP (1 << 11)
+
+#define IA32_MSR_SYSENTER_CS 0x174
+#define IA32_MSR_SYSENTER_ESP 0x175
+#define IA32_MSR_SYSENTER_EIP 0x176
+
 #ifndef __ASM__
 #include <lunaix/types.h>
 struct x86_tss
@@ -16,4 +16,12 @@
 #define CONFIG_PMALLOC_SIMPLE_PO8_THRES     64
 #define CONFIG_PMALLOC_SIMPLE_PO9_THRES     16
 
+#define CONFIG_NR_CPUS                      1
+
+#define CONFIG_CAKE_MAG_ROUNDS              16
+#define CONFIG_CAKE_DEPOT_MAXMAG            8
+
+// capacity of each ramfs instance, in pages
+#define CONFIG_RAMFS_MAX_PAGES              4096
+
 #endif /* __LUNAIX_CONFIG_H */
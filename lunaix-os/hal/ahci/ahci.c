@@ -29,7 +29,8 @@
 #define HBA_FIS_SIZE 256
 #define HBA_CLB_SIZE 1024
 
-#define HBA_MY_IE (HBA_PxINTR_DHR | HBA_PxINTR_TFE | HBA_PxINTR_OF)
+#define HBA_MY_IE                                                              \
+    (HBA_PxINTR_DHR | HBA_PxINTR_SDB | HBA_PxINTR_TFE | HBA_PxINTR_OF)
 #define AHCI_DEVCLASS DEVCLASS(DEVIF_PCI, DEVFN_STORAGE, DEV_SATA)
 
 // #define DO_HBA_FULL_RESET
@@ -198,6 +199,10 @@ ahci_register_device(struct hba_device* hbadev)
     bdev->blk_size = hbadev->block_size;
     bdev->class = &ahci_class;
 
+    blkio_set_depth(bdev->blkio, ahci_queue_depth(hbadev));
+    blkio_set_segments(bdev->blkio, HBA_MAX_PRDTE);
+    ahci_set_metrics(hbadev, bdev->blkio);
+
     block_mount(bdev, ahci_fsexport);
 }
 
@@ -206,7 +211,8 @@ __get_free_slot(struct hba_port* port)
 {
     hba_reg_t pxsact = port->regs[HBA_RPxSACT];
     hba_reg_t pxci = port->regs[HBA_RPxCI];
-    hba_reg_t free_bmp = pxsact | pxci;
+    // a slot is not reusable until its completion is retired by isr
+    hba_reg_t free_bmp = pxsact | pxci | port->cmdctx.tracked_ci;
     u32_t i = 0;
     for (; i <= port->hba->cmd_slots && (free_bmp & 0x1); i++, free_bmp >>= 1)
         ;
@@ -263,7 +269,7 @@ hba_bind_vbuf(struct hba_cmdh* cmdh, struct hba_cmdt* cmdt, struct vecbuf* vbuf)
         pos = list_entry(pos->components.next, struct vecbuf, components);
     } while (pos != vbuf);
 
-    cmdh->prdt_len = i + 1;
+    cmdh->prdt_len = i;
 
     return 0;
 }
@@ -339,6 +345,10 @@ ahci_init_device(struct hba_port* port)
     */
     ahci_parse_dev_info(port->device, data_in);
 
+    if (!(port->hba->base[HBA_RCAP] & HBA_CAP_SNCQ)) {
+        port->device->flags &= ~HBA_DEV_FNCQ;
+    }
+
     if (!(port->device->flags & HBA_DEV_FATAPI)) {
         goto done;
     }
@@ -28,10 +28,22 @@ sata_submit(struct hba_device* dev, struct blkio_req* io_req)
 
     header->options |= HBA_CMDH_WRITE * write;
 
+    // more commands may be queued behind, let the device tell us when it
+    //  is no longer busy.
+    header->options &= ~HBA_CMDH_CLR_BUSY;
+
     u16_t count = ICEIL(vbuf_size(io_req->vbuf), port->device->block_size);
     struct sata_reg_fis* fis = (struct sata_reg_fis*)table->command_fis;
 
-    if ((port->device->flags & HBA_DEV_FEXTLBA)) {
+    if ((port->device->flags & HBA_DEV_FNCQ)) {
+        // FPDMA: sector count goes to FEATURE, tag (same as slot) to COUNT
+        sata_create_fis(fis,
+                        write ? ATA_WRITE_FPDMA_QUEUED : ATA_READ_FPDMA_QUEUED,
+                        io_req->blk_addr,
+                        slot << 3);
+        fis->head.feat_err = count & 0xff;
+        fis->feature = count >> 8;
+    } else if ((port->device->flags & HBA_DEV_FEXTLBA)) {
         // 如果该设备支持48位LBA寻址
         sata_create_fis(fis,
                         write ? ATA_WRITE_DMA_EXT : ATA_READ_DMA_EXT,
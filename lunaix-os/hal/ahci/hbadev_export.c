@@ -34,6 +34,16 @@ __blk_rd_aoffset(struct twimap* map)
     twimap_printf(map, "%d", hbadev->alignment_offset);
 }
 
+void
+__blk_rd_qdepth(struct twimap* map)
+{
+    struct hba_device* hbadev = twimap_data(map, struct hba_device*);
+    twimap_printf(map,
+                  "%d%s",
+                  ahci_queue_depth(hbadev),
+                  (hbadev->flags & HBA_DEV_FNCQ) ? " ncq" : "");
+}
+
 void
 __blk_rd_wwid(struct twimap* map)
 {
@@ -67,4 +77,7 @@ ahci_fsexport(struct block_dev* bdev, void* fs_node)
 
     map = twifs_mapping(dev_root, bdev->driver, "alignment_offset");
     map->read = __blk_rd_aoffset;
+
+    map = twifs_mapping(dev_root, bdev->driver, "queue_depth");
+    map->read = __blk_rd_qdepth;
 }
\ No newline at end of file
@@ -6,6 +6,72 @@
 
 LOG_MODULE("io_evt")
 
+static void
+__ahci_port_isr(struct hba_port* port)
+{
+    struct hba_cmd_context* cmdctx = &port->cmdctx;
+    struct hba_cmd_state* cmdstate;
+    struct blkio_context* io_ctx = NULL;
+    struct blkio_req* ioreq;
+    u32_t active, processed, slot;
+
+    // acknowledge first, so completions arrive after this point
+    //  will raise another interrupt.
+    hba_reg_t port_is = port->regs[HBA_RPxIS];
+    port->regs[HBA_RPxIS] = port_is;
+
+    sata_read_error(port);
+
+    // a NCQ command remains in PxSACT until the device reports back
+    active = port->regs[HBA_RPxCI] | port->regs[HBA_RPxSACT];
+    processed = cmdctx->tracked_ci & ~active;
+
+    // FIXME When error occurs, CI will not change. Need error recovery!
+    if (!processed) {
+        if (port_is & HBA_FATAL) {
+            // TODO perform error recovery
+            // This should include:
+            //      1. Discard all issued (but pending) requests (signaled as
+            //      error)
+            //      2. Restart port
+            // Complete steps refer to AHCI spec 6.2.2.1
+        }
+        return;
+    }
+
+    cmdctx->tracked_ci &= ~processed;
+
+    while (processed) {
+        slot = ctz(processed);
+        processed &= ~(1 << slot);
+
+        cmdstate = cmdctx->issued[slot];
+        cmdctx->issued[slot] = NULL;
+
+        if (!cmdstate) {
+            continue;
+        }
+
+        ioreq = (struct blkio_req*)cmdstate->state_ctx;
+        io_ctx = ioreq->io_ctx;
+
+        if ((port->device->last_result.status & HBA_PxTFD_ERR)) {
+            ioreq->errcode = port->regs[HBA_RPxTFD] & 0xffff;
+            ioreq->flags |= BLKIO_ERROR;
+            hba_clear_reg(port->regs[HBA_RPxSERR]);
+        }
+
+        blkio_complete(ioreq);
+        vfree_dma(cmdstate->cmd_table);
+        vfree(cmdstate);
+    }
+
+    // refill the slots we just freed up
+    if (io_ctx) {
+        blkio_schedule(io_ctx);
+    }
+}
+
 void
 ahci_hba_isr(const isr_param* param)
 {
@@ -23,53 +89,29 @@ ahci_hba_isr(const isr_param* param)
 
     return;
 
-proceed:
+proceed:;
+    hba_reg_t pending = hba->base[HBA_RIS];
+
     // ignore spurious interrupt
-    if (!hba->base[HBA_RIS])
+    if (!pending)
         return;
 
-    u32_t port_num = 31 - clz(hba->base[HBA_RIS]);
-    struct hba_port* port = hba->ports[port_num];
-    struct hba_cmd_context* cmdctx = &port->cmdctx;
-    u32_t processed = port->regs[HBA_RPxCI] ^ cmdctx->tracked_ci;
-
-    sata_read_error(port);
-
-    // FIXME When error occurs, CI will not change. Need error recovery!
-    if (!processed) {
-        if (port->regs[HBA_RPxIS] & HBA_FATAL) {
-            // TODO perform error recovery
-            // This should include:
-            //      1. Discard all issued (but pending) requests (signaled as
-            //      error)
-            //      2. Restart port
-            // Complete steps refer to AHCI spec 6.2.2.1
+    for (u32_t bmp = pending; bmp; bmp &= bmp - 1) {
+        struct hba_port* port = hba->ports[ctz(bmp)];
+        if (!port) {
+            continue;
         }
-        goto done;
-    }
-
-    u32_t slot = 31 - clz(processed);
-    struct hba_cmd_state* cmdstate = cmdctx->issued[slot];
-
-    if (!cmdstate) {
-        goto done;
-    }
 
-    struct blkio_req* ioreq = (struct blkio_req*)cmdstate->state_ctx;
+        if (!port->device) {
+            hba_clear_reg(port->regs[HBA_RPxIS]);
+            continue;
+        }
 
-    if ((port->device->last_result.status & HBA_PxTFD_ERR)) {
-        ioreq->errcode = port->regs[HBA_RPxTFD] & 0xffff;
-        ioreq->flags |= BLKIO_ERROR;
-        hba_clear_reg(port->regs[HBA_RPxSERR]);
+        __ahci_port_isr(port);
     }
 
-    blkio_schedule(ioreq->io_ctx);
-    blkio_complete(ioreq);
-    vfree_dma(cmdstate->cmd_table);
-
-done:
-    hba_clear_reg(port->regs[HBA_RPxIS]);
-    hba->base[HBA_RIS] &= ~(1 << (31 - port_num));
+    // write-1-to-clear
+    hba->base[HBA_RIS] = pending;
 }
 
 void
@@ -4,6 +4,7 @@
 #include <hal/ahci/scsi.h>
 #include <klibc/string.h>
 
+#include <lunaix/blkio.h>
 #include <lunaix/spike.h>
 
 #define IDDEV_OFFMAXLBA 60
@@ -17,6 +18,9 @@
 #define IDDEV_OFFALIGN 209
 #define IDDEV_OFFLPP 106
 #define IDDEV_OFFCAPABILITIES 49
+#define IDDEV_OFFQDEPTH 75
+#define IDDEV_OFFROTRATE 217
+#define IDDEV_OFFSATACAP 76
 
 static u32_t cdb_size[] = { SCSI_CDB12, SCSI_CDB16, 0, 0 };
 
@@ -41,6 +45,20 @@ ahci_parse_dev_info(struct hba_device* dev_info, u16_t* data)
         dev_info->flags |= HBA_DEV_FEXTLBA;
     }
 
+    // word 76 bit 8: native command queuing supported
+    u16_t sata_cap = *(data + IDDEV_OFFSATACAP);
+    if (sata_cap != 0xffff && (sata_cap & 0x100)) {
+        dev_info->flags |= HBA_DEV_FNCQ;
+        dev_info->queue_depth = (*(data + IDDEV_OFFQDEPTH) & 0x1f) + 1;
+    }
+
+    // word 217: 1 for non-rotating media, otherwise nominal rpm (0 if not
+    //  reported)
+    dev_info->rotation_rate = *(data + IDDEV_OFFROTRATE);
+    if (dev_info->rotation_rate == 0xffff) {
+        dev_info->rotation_rate = 0;
+    }
+
     ahci_parsestr(dev_info->serial_num, data + IDDEV_OFFSERIALNUM, 10);
     ahci_parsestr(dev_info->model, data + IDDEV_OFFMODELNUM, 20);
 }
@@ -94,12 +112,63 @@ ahci_post(struct hba_port* port, struct hba_cmd_state* state, int slot)
 {
     int bitmask = 1 << slot;
 
-    // 确保端口是空闲的
-    wait_until(!(port->regs[HBA_RPxTFD] & (HBA_PxTFD_BSY | HBA_PxTFD_DRQ)));
-
-    hba_clear_reg(port->regs[HBA_RPxIS]);
+    /*
+        Other slots may still be in flight, so we neither wait for the
+        port to become idle nor touch PxIS here. The HBA itself will
+        serialize the non-queued commands.
+    */
 
     port->cmdctx.issued[slot] = state;
     port->cmdctx.tracked_ci |= bitmask;
-    port->regs[HBA_RPxCI] |= bitmask;
+
+    if ((port->device->flags & HBA_DEV_FNCQ)) {
+        port->regs[HBA_RPxSACT] = bitmask;
+    }
+
+    // PxCI is write-1-to-set, writing back what has been read could
+    //  re-issue a slot that just completed.
+    port->regs[HBA_RPxCI] = bitmask;
+}
+
+void
+ahci_set_metrics(struct hba_device* dev, struct blkio_context* ctx)
+{
+    u32_t rpm = dev->rotation_rate;
+
+    if ((dev->flags & HBA_DEV_FATAPI)) {
+        // optical drive, painfully slow on seeking
+        ctx->metrics.seektime = 100;
+        ctx->metrics.rotdelay = 0;
+        return;
+    }
+
+    if (rpm == 1) {
+        // solid state, no point to order the requests by lba.
+        ctx->metrics.seektime = 0;
+        ctx->metrics.rotdelay = 0;
+        return;
+    }
+
+    // assume a 7200 rpm disk when not reported.
+    rpm = (rpm >= 0x401 && rpm <= 0xfffe) ? rpm : 7200;
+
+    ctx->metrics.seektime = 8;
+    ctx->metrics.rotdelay = MAX(30000 / rpm, 1);
+}
+
+u32_t
+ahci_queue_depth(struct hba_device* dev)
+{
+    u32_t slots = dev->hba->cmd_slots + 1;
+
+    // nothing to gain from queuing on optical drives
+    if ((dev->flags & HBA_DEV_FATAPI)) {
+        return 1;
+    }
+
+    if ((dev->flags & HBA_DEV_FNCQ)) {
+        return MIN(slots, dev->queue_depth);
+    }
+
+    return slots;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ LOG_MODULE("APIC_TIMER")
 
 #define LVT_ENTRY_TIMER(vector, mode) (LVT_DELIVERY_FIXED | mode | vector)
 #define APIC_BASETICKS 0x100000
+#define APIC_MAX_COUNTS 0xffffffffU
 
 // Don't optimize them! Took me an half hour to figure that out...
 
@@ -20,6 +21,14 @@ static volatile u8_t apic_timer_done = 0;
 static volatile ticks_t base_freq = 0;
 static volatile ticks_t systicks = 0;
 
+static ticks_t tphz = 0;
+static u32_t iv_tick = 0;
+
+// non-zero if a oneshot is counting, the ticks it spans.
+static volatile ticks_t oneshot_ticks = 0;
+// sub-tick residue carried over from early wake up from oneshot.
+static volatile ticks_t residue = 0;
+
 static timer_tick_cb tick_cb = NULL;
 
 static void
@@ -28,10 +37,26 @@ temp_intr_routine_apic_timer(const isr_param* param)
     apic_timer_done = 1;
 }
 
+static void
+__apic_timer_periodic()
+{
+    oneshot_ticks = 0;
+
+    apic_write_reg(APIC_TIMER_ICR, 0);
+    apic_write_reg(APIC_TIMER_LVT,
+                   LVT_ENTRY_TIMER(iv_tick, LVT_TIMER_PERIODIC));
+    apic_write_reg(APIC_TIMER_ICR, tphz);
+}
+
 static void
 apic_timer_tick_isr(const isr_param* param)
 {
-    systicks++;
+    if (oneshot_ticks) {
+        systicks += oneshot_ticks;
+        __apic_timer_periodic();
+    } else {
+        systicks++;
+    }
 
     if (likely((ptr_t)tick_cb)) {
         tick_cb();
@@ -51,6 +76,38 @@ apic_get_systicks()
     return systicks;
 }
 
+static ticks_t
+apic_timer_oneshot(struct hwtimer* hwt, ticks_t ticks)
+{
+    ticks = MIN(ticks, APIC_MAX_COUNTS / tphz);
+
+    apic_write_reg(APIC_TIMER_ICR, 0);
+    apic_write_reg(APIC_TIMER_LVT,
+                   LVT_ENTRY_TIMER(iv_tick, LVT_TIMER_ONESHOT));
+
+    oneshot_ticks = ticks;
+    apic_write_reg(APIC_TIMER_ICR, ticks * tphz);
+
+    return ticks;
+}
+
+static void
+apic_timer_resume(struct hwtimer* hwt)
+{
+    if (!oneshot_ticks) {
+        // fired already, we are back to periodic.
+        return;
+    }
+
+    ticks_t elapsed = oneshot_ticks * tphz - apic_read_reg(APIC_TIMER_CCR);
+
+    elapsed += residue;
+    systicks += elapsed / tphz;
+    residue = elapsed % tphz;
+
+    __apic_timer_periodic();
+}
+
 static ticks_t
 apic_get_base_freq()
 {
@@ -137,13 +194,11 @@ apic_timer_init(struct hwtimer* timer, u32_t hertz, timer_tick_cb timer_cb)
     // cleanup
     isrm_ivfree(iv_timer);
 
-    ticks_t tphz = base_freq / frequency;
+    tphz = base_freq / frequency;
     timer->base_freq = base_freq;
-    apic_write_reg(APIC_TIMER_ICR, tphz);
 
-    apic_write_reg(
-      APIC_TIMER_LVT,
-      LVT_ENTRY_TIMER(isrm_ivexalloc(apic_timer_tick_isr), LVT_TIMER_PERIODIC));
+    iv_tick = isrm_ivexalloc(apic_timer_tick_isr);
+    __apic_timer_periodic();
 }
 
 struct hwtimer*
@@ -154,7 +209,9 @@ apic_hwtimer_context()
         .class = DEVCLASSV(DEVIF_SOC, DEVFN_TIME, DEV_TIMER, DEV_TIMER_APIC),
         .init = apic_timer_init,
         .supported = apic_timer_check,
-        .systicks = apic_get_systicks
+        .systicks = apic_get_systicks,
+        .oneshot = apic_timer_oneshot,
+        .resume = apic_timer_resume
     };
 
     return &apic_hwt;
@@ -33,6 +33,26 @@ hwtimer_to_ticks(u32_t value, int unit)
     return freq_ms * value;
 }
 
+ticks_t
+hwtimer_oneshot(ticks_t ticks)
+{
+    assert(systimer);
+    if (!systimer->oneshot) {
+        return 0;
+    }
+
+    return systimer->oneshot((struct hwtimer*)systimer, ticks);
+}
+
+void
+hwtimer_resume()
+{
+    assert(systimer);
+    if (systimer->resume) {
+        systimer->resume((struct hwtimer*)systimer);
+    }
+}
+
 static int
 __hwtimer_ioctl(struct device* dev, u32_t req, va_list args)
 {
@@ -55,6 +55,24 @@ ahci_try_send(struct hba_port* port, int slot);
 void
 ahci_post(struct hba_port* port, struct hba_cmd_state* state, int slot);
 
+/**
+ * @brief Number of commands that can be outstanding on the device
+ *
+ * @param dev
+ * @return u32_t
+ */
+u32_t
+ahci_queue_depth(struct hba_device* dev);
+
+/**
+ * @brief Fill in the seek characteristics of device for io scheduler
+ *
+ * @param dev
+ * @param ctx
+ */
+void
+ahci_set_metrics(struct hba_device* dev, struct blkio_context* ctx);
+
 struct ahci_driver*
 ahci_driver_init(struct ahci_driver_param* param);
 
@@ -34,6 +34,7 @@
 #define HBA_PxCMD_ST (1)
 #define HBA_PxINTR_DMA (1 << 2)
 #define HBA_PxINTR_DHR (1)
+#define HBA_PxINTR_SDB (1 << 3)
 #define HBA_PxINTR_DPS (1 << 5)
 #define HBA_PxINTR_TFE (1 << 30)
 #define HBA_PxINTR_HBF (1 << 29)
@@ -54,6 +55,8 @@
 #define HBA_RGHC_INTR_ENABLE (1 << 1)
 #define HBA_RGHC_RESET 1
 
+#define HBA_CAP_SNCQ (1 << 30)
+
 #define HBA_RPxSSTS_PWR(x) (((x) >> 8) & 0xf)
 #define HBA_RPxSSTS_IF(x) (((x) >> 4) & 0xf)
 #define HBA_RPxSSTS_PHYSTATE(x) ((x)&0xf)
@@ -75,7 +78,7 @@ typedef unsigned int hba_reg_t;
 #define HBA_CMDH_CLR_BUSY (1 << 10)
 #define HBA_CMDH_PRDT_LEN(entries) (((entries)&0xffff) << 16)
 
-#define HBA_MAX_PRDTE 4
+#define HBA_MAX_PRDTE 16
 
 struct hba_cmdh
 {
@@ -105,6 +108,7 @@ struct hba_cmdt
 
 #define HBA_DEV_FEXTLBA 1
 #define HBA_DEV_FATAPI (1 << 1)
+#define HBA_DEV_FNCQ (1 << 2)
 
 struct hba_port;
 struct ahci_hba;
@@ -128,6 +132,8 @@ struct hba_device
     u32_t alignment_offset;
     u32_t block_per_sec;
     u32_t capabilities;
+    u32_t queue_depth;
+    u32_t rotation_rate;
     struct hba_port* port;
     struct ahci_hba* hba;
 
@@ -15,6 +15,8 @@
 #define ATA_READ_DMA 0xc8
 #define ATA_WRITE_DMA_EXT 0x35
 #define ATA_WRITE_DMA 0xca
+#define ATA_READ_FPDMA_QUEUED 0x60
+#define ATA_WRITE_FPDMA_QUEUED 0x61
 
 #define MAX_RETRY 2
 
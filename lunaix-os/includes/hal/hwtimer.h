@@ -18,6 +18,20 @@ struct hwtimer
     int (*supported)(struct hwtimer*);
     void (*init)(struct hwtimer*, u32_t hertz, timer_tick_cb);
     ticks_t (*systicks)();
+
+    /*
+        Optional. Stop the periodic tick and fire only once after given
+        system ticks, return the ticks actually programmed. The tick 
+        delivered by then should account for all skipped ticks.
+    */
+    ticks_t (*oneshot)(struct hwtimer*, ticks_t ticks);
+
+    /*
+        Optional. Revert to periodic tick, catching up the ticks elapsed
+        so far if the oneshot has not yet fired.
+    */
+    void (*resume)(struct hwtimer*);
+
     ticks_t base_freq;
     ticks_t running_freq;
 };
@@ -37,4 +51,10 @@ hwtimer_current_systicks();
 ticks_t
 hwtimer_to_ticks(u32_t value, int unit);
 
+ticks_t
+hwtimer_oneshot(ticks_t ticks);
+
+void
+hwtimer_resume();
+
 #endif /* __LUNAIX_HWTIMER_H */
@@ -4,6 +4,7 @@
 #include <lunaix/buffer.h>
 #include <lunaix/ds/llist.h>
 #include <lunaix/ds/waitq.h>
+#include <lunaix/time.h>
 #include <lunaix/types.h>
 
 #define BLKIO_WRITE 0x1
@@ -18,16 +19,43 @@
 // Free on complete
 #define BLKIO_FOC 0x10
 
+// Composed from several adjacent requests by scheduler
+#define BLKIO_MERGED 0x20
+
 #define BLKIO_SCHED_IDEL 0x1
 
+// contexts a plug can hold back at once
+#define BLKIO_PLUG_MAXCTX 4
+
 struct blkio_req;
+struct blkio_context;
+struct thread;
 
 typedef void (*blkio_cb)(struct blkio_req*);
 typedef void (*req_handler)(struct blkio_req*);
 
+/**
+ * @brief IO scheduling policy. Decides the order in which the queued
+ * requests are handed to driver.
+ *
+ */
+struct blkio_sched
+{
+    const char* name;
+    void (*enqueue)(struct blkio_context* ctx, struct blkio_req* req);
+    struct blkio_req* (*pick)(struct blkio_context* ctx);
+};
+
+extern const struct blkio_sched blkio_sched_fifo;
+extern const struct blkio_sched blkio_sched_elevator;
+extern const struct blkio_sched blkio_sched_deadline;
+
 struct blkio_req
 {
     struct llist_header reqs;
+    struct llist_header sched_link;
+    struct llist_header merged;
+    time_t deadline;
     struct blkio_context* io_ctx;
     struct vecbuf* vbuf;
     u32_t flags;
@@ -41,17 +69,56 @@ struct blkio_req
 struct blkio_context
 {
     struct llist_header queue;
+    struct llist_header expiry;
     struct
     {
+        // average seek and rotational latency in ms, zero for
+        //  non-rotational devices.
         u32_t seektime;
         u32_t rotdelay;
     } metrics;
+    const struct blkio_sched* sched;
+    u64_t head_pos;
     req_handler handle_one;
     u32_t state;
     u32_t busy;
+    u32_t depth;
+    u32_t blk_size;
+    u32_t max_segs;
+    struct
+    {
+        // requests handed to driver, and those absorbed into another
+        u32_t dispatched;
+        u32_t merged;
+    } stats;
     void* driver;
 };
 
+/**
+ * @brief Holds back the dispatch of asynchronous requests committed by its
+ * owner, so a batch gets queued as a whole before the scheduler (and
+ * merger) get to see it. Lives on the stack of the submitter.
+ *
+ */
+struct blkio_plug
+{
+    struct thread* owner;
+    struct blkio_context* held[BLKIO_PLUG_MAXCTX];
+    u32_t nr_held;
+};
+
+static inline bool
+blkio_rotational(struct blkio_context* ctx)
+{
+    return ctx->metrics.seektime || ctx->metrics.rotdelay;
+}
+
+static inline size_t
+blkio_nr_blocks(struct blkio_req* req)
+{
+    return vbuf_size(req->vbuf) / req->io_ctx->blk_size;
+}
+
 void
 blkio_init();
 
@@ -102,7 +169,29 @@ void
 blkio_commit(struct blkio_context* ctx, struct blkio_req* req, int options);
 
 /**
- * @brief Schedule an IO request to be handled.
+ * @brief Start plugging. Asynchronous requests committed by the current
+ * thread are queued but not dispatched until `blkio_unplug`. Requests
+ * committed with BLKIO_WAIT still kick the queue.
+ *
+ * Only one plug can be active at a time, a plug started while another is
+ * active does nothing.
+ *
+ * @param plug
+ */
+void
+blkio_plug(struct blkio_plug* plug);
+
+/**
+ * @brief Stop plugging and dispatch what has been held back.
+ *
+ * @param plug
+ */
+void
+blkio_unplug(struct blkio_plug* plug);
+
+/**
+ * @brief Schedule pending IO requests to be handled, as many as the
+ * context's queue depth allows.
  *
  * @param ctx
  */
@@ -128,4 +217,39 @@ blkio_complete(struct blkio_req* req);
 struct blkio_context*
 blkio_newctx(req_handler handler);
 
+/**
+ * @brief Set the maximum number of in-flight requests that the
+ * underlying driver can take.
+ *
+ * @param ctx
+ * @param depth
+ */
+static inline void
+blkio_set_depth(struct blkio_context* ctx, u32_t depth)
+{
+    ctx->depth = depth ? depth : 1;
+}
+
+/**
+ * @brief Set the maximum number of buffer segments a single request can
+ * carry to driver. Requests are merged only up to this limit.
+ *
+ * @param ctx
+ * @param segs
+ */
+static inline void
+blkio_set_segments(struct blkio_context* ctx, u32_t segs)
+{
+    ctx->max_segs = segs ? segs : 1;
+}
+
+/**
+ * @brief Switch the scheduling policy. Must be done when the queue is empty.
+ *
+ * @param ctx
+ * @param sched
+ */
+void
+blkio_set_sched(struct blkio_context* ctx, const struct blkio_sched* sched);
+
 #endif /* __LUNAIX_BLKIO_H */
@@ -23,7 +23,37 @@ clock_walltime(datetime_t* datetime);
 time_t
 clock_systime();
 
+/**
+ * @brief Seconds since unix epoch. Kept by ticks, cheap enough for
+ * stamping every file access.
+ *
+ * @return time_t
+ */
 time_t
 clock_unixtime();
 
+/**
+ * @brief Nanoseconds since boot, never goes backward.
+ *
+ * @return u64_t
+ */
+u64_t
+clock_monotonic();
+
+/**
+ * @brief Nanoseconds since unix epoch.
+ *
+ * @return u64_t
+ */
+u64_t
+clock_realtime();
+
+/**
+ * @brief Advance the clock, called on every system tick.
+ *
+ * @param now current systicks
+ */
+void
+clock_tick(ticks_t now);
+
 #endif /* __LUNAIX_CLOCK_H */
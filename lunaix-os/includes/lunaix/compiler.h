@@ -13,8 +13,10 @@
 #define must_emit               __attribute__((used))
 #define unreachable             __builtin_unreachable()
 #define no_inline               __attribute__((noinline))
+#define barrier()               asm volatile("" ::: "memory")
 
 #define clz(bits)               __builtin_clz(bits)
+#define ctz(bits)               __builtin_ctz(bits)
 #define sadd_overflow(a, b, of) __builtin_sadd_overflow(a, b, of)
 #define umul_overflow(a, b, of) __builtin_umul_overflow(a, b, of)
 #define offsetof(f, m)          __builtin_offsetof(f, m)
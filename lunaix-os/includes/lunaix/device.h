@@ -121,6 +121,15 @@ struct capability_meta
 
 typedef struct llist_header capability_list_t;
 
+/**
+ * @brief Completion of an asynchronous device io. `result` is number of
+ * bytes transferred, or negative error code. May be invoked within
+ * interrupt context.
+ */
+typedef void (*devio_done_cb)(void* arg, int result);
+
+struct vecbuf;
+
 
 struct device_meta
 {
@@ -199,6 +208,20 @@ struct device
         int (*read_page)(struct device*, void*, off_t);
         int (*write_page)(struct device*, void*, off_t);
 
+        // optional, issue a page read and return without waiting.
+        int (*read_page_async)(struct device*,
+                               void*,
+                               off_t,
+                               devio_done_cb,
+                               void*);
+
+        // optional, write the whole vectored buffer to consecutive blocks.
+        int (*write_pages)(struct device*, struct vecbuf*, off_t);
+
+        // optional, fill the whole vectored buffer from consecutive blocks.
+        //  Every component must be a multiple of block size.
+        int (*read_pages)(struct device*, struct vecbuf*, off_t);
+
         int (*exec_cmd)(struct device*, u32_t, va_list);
         int (*poll)(struct device*);
     } ops;
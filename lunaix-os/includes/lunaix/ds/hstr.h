@@ -2,6 +2,7 @@
 #define __LUNAIX_HSTR_H
 
 #include <lib/hash.h>
+#include <klibc/string.h>
 
 #define HSTR_FULL_HASH 32
 
@@ -32,6 +33,18 @@ hstr_rehash(struct hstr* hash_str, u32_t truncate_to)
     hash_str->hash = strhash_32(hash_str->value, truncate_to);
 }
 
+/**
+ * @brief Compare the content, hash serves only as a quick rejection, as
+ * collision does happen.
+ *
+ */
+static inline bool
+hstreq(struct hstr* a, struct hstr* b)
+{
+    return a->hash == b->hash && a->len == b->len &&
+           !memcmp(a->value, b->value, a->len);
+}
+
 void
 hstrcpy(struct hstr* dest, struct hstr* src);
 
@@ -4,23 +4,67 @@
 #include <lunaix/ds/llist.h>
 #include <lunaix/types.h>
 
+#define LRU_CLASSIC 0
+#define LRU_2Q 1
+
+struct hbucket;
+
 struct lru_node
 {
     struct llist_header lru_nodes;
+    u32_t queue;
 };
 
 typedef int (*evict_cb)(struct lru_node* lru_obj);
 
+/**
+ * @brief Identity of the object behind a lru_node. Used by 2Q to recognize
+ * the object that had been evicted not long ago when it comes back.
+ */
+typedef u32_t (*lru_key_cb)(struct lru_node* lru_obj);
+
 struct lru_zone
 {
+    const char* name;
     struct llist_header lead_node;
     struct llist_header zones;
     u32_t objects;
+    u32_t mode;
     evict_cb try_evict;
+
+    /* -- 2Q -- */
+    struct llist_header a1in;
+    struct llist_header a1out;
+    struct hbucket* ghosts;
+    lru_key_cb key;
+    u32_t nr_a1in;
+    u32_t nr_a1out;
+
+    struct
+    {
+        u32_t hits;
+        u32_t misses;
+        u32_t ghost_hits;
+        u32_t evicted;
+    } stats;
 };
 
+/**
+ * @brief Create a zone with plain LRU replacement
+ *
+ */
+struct lru_zone*
+lru_new_zone(const char* name, evict_cb try_evict_cb);
+
+/**
+ * @brief Create a zone with 2Q replacement. Objects used only once are kept
+ * in a FIFO and evicted before anything in the main LRU, thus a single scan
+ * can not flush the working set out. An object gets into main LRU only when
+ * it is used again shortly after its eviction.
+ *
+ */
 struct lru_zone*
-lru_new_zone(evict_cb try_evict_cb);
+lru_new_zone_2q(const char* name, evict_cb try_evict_cb, lru_key_cb key_cb);
 
 void
 lru_use_one(struct lru_zone* zone, struct lru_node* node);
@@ -0,0 +1,91 @@
+#ifndef __LUNAIX_RADIX_H
+#define __LUNAIX_RADIX_H
+
+#include <lunaix/types.h>
+
+#define RADIX_BITS 5
+#define RADIX_SLOTS (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SLOTS - 1)
+
+#define RADIX_MAX_TAGS 2
+
+/*
+    Every slot has a bit in `present`. Each tag has a bitmap of same
+    layout, an internal node has the tag bit set on a slot if anything
+    beneath it is tagged.
+*/
+struct radix_node
+{
+    struct radix_node* parent;
+    u32_t offset;
+    u32_t count;
+    u32_t present;
+    u32_t tags[RADIX_MAX_TAGS];
+    void* slots[RADIX_SLOTS];
+};
+
+struct radix_tree
+{
+    struct radix_node* root;
+    u32_t height;
+};
+
+void
+radix_init(struct radix_tree* tree);
+
+void*
+radix_get(struct radix_tree* tree, u32_t index);
+
+/**
+ * @brief Put `item` at `index`, replacing whatever was there.
+ *
+ * @return int 0 on success, ENOMEM if node allocation failed
+ */
+int
+radix_set(struct radix_tree* tree, u32_t index, void* item);
+
+void*
+radix_remove(struct radix_tree* tree, u32_t index);
+
+/**
+ * @brief Collect at most `max` items, in ascending order of index, starting
+ * from `start`.
+ *
+ * @return size_t number of items collected
+ */
+size_t
+radix_gang_lookup(struct radix_tree* tree,
+                  void** items,
+                  u32_t start,
+                  size_t max);
+
+/**
+ * @brief Same as radix_gang_lookup, but only those carrying `tag`.
+ *
+ */
+size_t
+radix_gang_lookup_tag(struct radix_tree* tree,
+                      void** items,
+                      u32_t start,
+                      size_t max,
+                      int tag);
+
+void
+radix_tag_set(struct radix_tree* tree, u32_t index, int tag);
+
+void
+radix_tag_clear(struct radix_tree* tree, u32_t index, int tag);
+
+bool
+radix_tag_get(struct radix_tree* tree, u32_t index, int tag);
+
+static inline bool
+radix_tagged(struct radix_tree* tree, int tag)
+{
+    return tree->root && tree->root->tags[tag];
+}
+
+void
+radix_release(struct radix_tree* tree);
+
+#endif /* __LUNAIX_RADIX_H */
@@ -0,0 +1,69 @@
+#ifndef __LUNAIX_RHASH_H
+#define __LUNAIX_RHASH_H
+
+#include <lunaix/ds/hashtable.h>
+
+#define RHASH_MAX_ORDER 15
+
+// number of old buckets moved per operation during resizing
+#define RHASH_STEP 4
+
+/*
+    A hash table that grows and shrinks on load, without stopping the world.
+
+    During resizing, old and new bucket arrays co-exist, old buckets are moved
+    into the new array a few at a time on each add or lookup. Entries of any
+    given key always stay together: in the new array if their old bucket had
+    been moved, in the old array otherwise. Thus a lookup is still a single
+    bucket walk.
+*/
+
+/**
+ * @brief Give the key of an entry. Used for re-distributing entries.
+ */
+typedef u32_t (*rhash_key_cb)(struct hlist_node* node);
+
+struct rhash_table
+{
+    struct hbucket* buckets;
+    struct hbucket* moving; // old buckets yet to move, if resizing
+    u32_t order;
+    u32_t moving_order;
+    u32_t moved;
+    u32_t min_order;
+    u32_t entries;
+    rhash_key_cb key;
+};
+
+void
+rhash_init(struct rhash_table* table, u32_t min_order, rhash_key_cb key);
+
+/**
+ * @brief Get the bucket where entries of `key` live. Entries must only be
+ * added or removed with rhash_add and rhash_remove.
+ *
+ * Might move some entries around, thus call it once per walk and keep the
+ * returned bucket.
+ *
+ */
+struct hbucket*
+rhash_bucket(struct rhash_table* table, u32_t key);
+
+void
+rhash_add(struct rhash_table* table, struct hlist_node* node, u32_t key);
+
+/**
+ * @brief Remove an entry, it is fine if it had been detached already.
+ *
+ */
+void
+rhash_remove(struct rhash_table* table, struct hlist_node* node);
+
+/**
+ * @brief Detach every entry and free the buckets.
+ *
+ */
+void
+rhash_release(struct rhash_table* table);
+
+#endif /* __LUNAIX_RHASH_H */
@@ -43,6 +43,7 @@ struct uexec_param
     char** argv;
     int envc;
     char** envp;
+    void* vdso;
 } compact;
 
 #ifndef __USR_WRAPPER__
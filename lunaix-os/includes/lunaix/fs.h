@@ -3,13 +3,15 @@
 
 #include <lunaix/clock.h>
 #include <lunaix/device.h>
-#include <lunaix/ds/btrie.h>
 #include <lunaix/ds/hashtable.h>
 #include <lunaix/ds/hstr.h>
 #include <lunaix/ds/ldga.h>
 #include <lunaix/ds/llist.h>
 #include <lunaix/ds/lru.h>
 #include <lunaix/ds/mutex.h>
+#include <lunaix/ds/radix.h>
+#include <lunaix/ds/rhash.h>
+#include <lunaix/ds/waitq.h>
 #include <lunaix/status.h>
 
 #include <stdatomic.h>
@@ -25,6 +27,7 @@
 #define VFS_IFSEQDEV (F_SEQDEV | F_FILE)
 #define VFS_IFVOLDEV (F_VOLDEV | F_FILE)
 #define VFS_IFSYMLINK (F_SYMLINK | F_FILE)
+#define VFS_IFPIPE (F_PIPE | F_FILE)
 
 #define VFS_DEVFILE(type) ((type) & F_DEV)
 #define VFS_DEVTYPE(type) ((type) & ((F_SEQDEV | F_VOLDEV) ^ F_DEV))
@@ -44,14 +47,16 @@
 // Do not follow the symbolic link
 #define VFS_WALK_NOFOLLOW 0x8
 
-#define VFS_HASHTABLE_BITS 10
-#define VFS_HASHTABLE_SIZE (1 << VFS_HASHTABLE_BITS)
-#define VFS_HASH_MASK (VFS_HASHTABLE_SIZE - 1)
-#define VFS_HASHBITS (32 - VFS_HASHTABLE_BITS)
+// initial (and minimal) order of dcache and inode cache
+#define VFS_DCACHE_ORDER 8
+#define VFS_ICACHE_ORDER 4
 
 #define VFS_PATH_DELIM '/'
 
 #define FSTYPE_ROFS 0x1
+// content may change without going through vfs, failed lookup must not be
+//  cached
+#define FSTYPE_PSEUDO 0x2
 
 #define TEST_FD(fd) (fd >= 0 && fd < VFS_MAX_FD)
 
@@ -88,6 +93,7 @@ struct v_inode_ops;
 struct v_fd;
 struct pcache;
 struct v_xattr_entry;
+struct leaflet;
 
 extern struct v_file_ops default_file_ops;
 extern struct v_inode_ops default_inode_ops;
@@ -113,7 +119,7 @@ struct v_superblock
     struct device* dev;
     struct v_dnode* root;
     struct filesystem* fs;
-    struct hbucket* i_cache;
+    struct rhash_table i_cache;
     void* data;
     size_t blksize;
     struct
@@ -148,10 +154,32 @@ struct v_file_ops
     int (*write_page)(struct v_inode* inode, void* pg, size_t fpos);
     int (*read_page)(struct v_inode* inode, void* pg, size_t fpos);
 
+    // optional, used by page cache to prefetch pages ahead of reader.
+    int (*read_page_async)(struct v_inode* inode,
+                           void* pg,
+                           size_t fpos,
+                           devio_done_cb done,
+                           void* arg);
+
+    // optional, write a run of file-contiguous pages starting at `fpos`
+    //  in one go. Used by page cache writeback.
+    int (*write_pages)(struct v_inode* inode,
+                       struct vecbuf* pages,
+                       size_t fpos);
+
     int (*readdir)(struct v_file* file, struct dir_context* dctx);
     int (*seek)(struct v_inode* inode, size_t offset); // optional
+
+    // optional, change `fsize` to exactly `size`. Called before a write
+    //  extends the file, so fs can refuse it.
+    int (*truncate)(struct v_inode* inode, size_t size);
     int (*close)(struct v_file* file);
     int (*sync)(struct v_file* file);
+
+    // optional, for files not backed by a device. Return the _POLL* events
+    //  currently present, and if `pollers` is given, the queue where pollers
+    //  get woken up on change.
+    int (*poll)(struct v_file* file, struct llist_header** pollers);
 };
 
 struct v_inode_ops
@@ -185,12 +213,38 @@ struct v_xattr_entry
     size_t len;
 };
 
+/**
+ * @brief Per-open-file readahead state
+ *
+ */
+struct pcache_ra
+{
+    u32_t next;   // where a sequential read is expected to start
+    u32_t ahead;  // prefetched up to here
+    u32_t window; // in pages
+};
+
+/**
+ * @brief Where a directory listing is at, so the next entry is found
+ * without counting from the start.
+ *
+ */
+struct dir_cursor
+{
+    struct llist_header trackers; // other cursors on the same directory
+    struct llist_header* pos;     // list node of the entry emitted last
+    u32_t index;                  // index of the entry to emit next
+    u32_t tag;                    // fs specific, to validate `pos`
+};
+
 struct v_file
 {
     struct v_inode* inode;
     struct v_dnode* dnode;
     struct llist_header* f_list;
     u32_t f_pos;
+    struct pcache_ra ra;
+    struct dir_cursor dcursor;
     atomic_ulong ref_count;
     struct v_file_ops* ops; // for caching
 };
@@ -258,12 +312,13 @@ struct v_dnode
     mutex_t lock; // sync the path walking
     struct lru_node lru;
     struct hstr name;
-    struct v_inode* inode;
+    struct v_inode* inode;  // NULL if negative, i.e., name known to be absent
     struct v_dnode* parent;
     struct hlist_node hash_list;
     struct llist_header aka_list;
     struct llist_header children;
     struct llist_header siblings;
+    struct llist_header cursors; // listings of `children` in progress
     struct v_superblock* super_block;
     struct v_mount* mnt;
     atomic_ulong ref_count;
@@ -279,11 +334,16 @@ struct v_fdtable
 struct pcache
 {
     struct v_inode* master;
-    struct btrie tree;
+    struct radix_tree tree;
     struct llist_header pages;
     struct llist_header dirty;
+    struct llist_header wb_list;
+    waitq_t inflight_wq;
     u32_t n_dirty;
     u32_t n_pages;
+    u32_t n_inflight;
+    // pages are the only copy of file data, never evicted nor written back
+    bool resident;
 };
 
 struct pcache_pg
@@ -296,6 +356,7 @@ struct pcache_pg
     u32_t flags;
     u32_t fpos;
     u32_t len;
+    time_t dirtied;
 };
 
 static inline bool
@@ -337,6 +398,36 @@ vfs_dcache_rehash(struct v_dnode* new_parent, struct v_dnode* dnode);
 void
 vfs_dcache_remove(struct v_dnode* dnode);
 
+/**
+ * @brief Drop all negative entries under `dir`, used when whatever
+ * underneath `dir` is changed in bulk (e.g., mounting)
+ *
+ */
+void
+vfs_dcache_prune_negative(struct v_dnode* dir);
+
+/**
+ * @brief Get `cursor` stepped off the nodes removed from a list, by whoever
+ * calls vfs_dcursor_evict on `cursors`.
+ *
+ */
+void
+vfs_dcursor_track(struct dir_cursor* cursor, struct llist_header* cursors);
+
+/**
+ * @brief Move cursors resting on `node` back to its predecessor. Must be
+ * called before `node` leaves the list.
+ *
+ */
+void
+vfs_dcursor_evict(struct llist_header* cursors, struct llist_header* node);
+
+static inline bool
+vfs_d_negative(struct v_dnode* dnode)
+{
+    return !dnode->inode;
+}
+
 int
 vfs_walk(struct v_dnode* start,
          const char* path,
@@ -374,6 +465,24 @@ vfs_mkdir(const char* path, struct v_dnode** dentry);
 int
 vfs_open(struct v_dnode* dnode, struct v_file** file);
 
+/**
+ * @brief Open an inode that has no name. `dnode` is not looked at for the
+ * inode, but only for the mount.
+ *
+ */
+int
+vfs_open_anon(struct v_dnode* dnode,
+              struct v_inode* inode,
+              struct v_file** file);
+
+/**
+ * @brief Take a free fd of current process for `file`.
+ *
+ * @return int the fd, or error
+ */
+int
+vfs_install_fd(struct v_file* file, int flags);
+
 int
 vfs_pclose(struct v_file* file, pid_t pid);
 
@@ -455,12 +564,57 @@ pcache_get_page(struct pcache* pcache,
 int
 pcache_write(struct v_inode* inode, void* data, u32_t len, u32_t fpos);
 
+/**
+ * @brief Read through page cache. If `ra` is given, pages ahead of the
+ * read are prefetched according to the observed access pattern.
+ *
+ */
 int
-pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos);
+pcache_read(struct v_inode* inode,
+            struct pcache_ra* ra,
+            void* data,
+            u32_t len,
+            u32_t fpos);
+
+struct pcache_pg*
+pcache_lookup(struct pcache* pcache, u32_t fpos);
+
+/**
+ * @brief Get the cached page at `fpos` ready for being mapped into user
+ * space, filling it up if necessary. The underlying leaflet is returned
+ * with an extra reference taken on behalf of the mapping.
+ *
+ */
+int
+pcache_map_page(struct v_inode* inode, u32_t fpos, struct leaflet** leaflet);
+
+/**
+ * @brief Same as pcache_map_page, but only if the page is cached and up to
+ * date, no I/O is involved.
+ *
+ */
+bool
+pcache_map_cached(struct v_inode* inode, u32_t fpos, struct leaflet** leaflet);
+
+/**
+ * @brief Start filling pages in [start, end) that are not yet cached,
+ * without waiting for them.
+ *
+ */
+void
+pcache_prefetch(struct v_inode* inode, u32_t start, u32_t end);
 
 void
 pcache_release(struct pcache* pcache);
 
+/**
+ * @brief Drop every page beyond `size` and clear the tail of the page
+ * where `size` falls in.
+ *
+ */
+void
+pcache_truncate(struct pcache* pcache, u32_t size);
+
 int
 pcache_commit(struct v_inode* inode, struct pcache_pg* page);
 
@@ -470,6 +624,13 @@ pcache_commit_all(struct v_inode* inode);
 void
 pcache_invalidate(struct pcache* pcache, struct pcache_pg* page);
 
+/**
+ * @brief Entry of the page cache writeback kernel thread.
+ *
+ */
+void
+pcache_writeback_main();
+
 /**
  * @brief 将挂载点标记为繁忙
  *
@@ -343,6 +343,13 @@ iso9660_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos);
 int
 iso9660_read_page(struct v_inode* inode, void* buffer, size_t fpos);
 
+int
+iso9660_read_page_async(struct v_inode* inode,
+                        void* buffer,
+                        size_t fpos,
+                        devio_done_cb done,
+                        void* arg);
+
 int
 iso9660_write_page(struct v_inode* inode, void* buffer, size_t fpos);
 
@@ -0,0 +1,52 @@
+#ifndef __LUNAIX_PIPE_H
+#define __LUNAIX_PIPE_H
+
+#include <lunaix/ds/llist.h>
+#include <lunaix/ds/waitq.h>
+#include <lunaix/mm/pagetable.h>
+#include <lunaix/types.h>
+
+// pages in the ring, thus 64KiB of buffering
+#define PIPE_SLOTS 16
+
+// writes no larger than this are never interleaved with others
+#define PIPE_BUF PAGE_SIZE
+
+#define PIPE_NONBLOCK 0x1
+
+/*
+    Data is kept in a ring of pages. A page is allocated the first time
+    its slot is used, and stays with the ring until the pipe is gone.
+
+    Writer fills the last slot and moves on to the next one only after it
+    is full, so every slot in use but the last is full. Reader takes whole
+    slots off the front once drained.
+*/
+struct pipe_slot
+{
+    void* pg;
+    u32_t start; // first byte not yet read
+    u32_t end;   // past the last byte written
+};
+
+struct pipe
+{
+    waitq_t rd_wait;
+    waitq_t wr_wait;
+    struct llist_header pollers;
+    struct pipe_slot ring[PIPE_SLOTS];
+    u32_t head; // slots ever taken by writer
+    u32_t tail; // slots ever retired by reader
+    u32_t avail;
+    u32_t flags;
+    u32_t refs; // inodes of both ends
+    bool reader;
+    bool writer;
+};
+
+#define PIPE(data) ((struct pipe*)(data))
+
+void
+pipefs_init();
+
+#endif /* __LUNAIX_PIPE_H */
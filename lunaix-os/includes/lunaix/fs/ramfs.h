@@ -13,7 +13,14 @@ struct ram_inode
     char* symlink;
 };
 
+struct ram_sb
+{
+    u32_t max_pages;
+    u32_t used_pages; // pages covered by file sizes
+};
+
 #define RAM_INODE(data) ((struct ram_inode*)(data))
+#define RAM_SB(data) ((struct ram_sb*)(data))
 
 void
 ramfs_init();
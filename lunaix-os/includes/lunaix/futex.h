@@ -0,0 +1,14 @@
+#ifndef __LUNAIX_FUTEX_H
+#define __LUNAIX_FUTEX_H
+
+#include <lunaix/mm/procvm.h>
+
+/**
+ * @brief Free the wait queues of `mm` that have run empty. A waiter
+ * destroyed while blocked would leave its queue behind otherwise.
+ *
+ */
+void
+futex_reclaim(struct proc_mm* mm);
+
+#endif /* __LUNAIX_FUTEX_H */
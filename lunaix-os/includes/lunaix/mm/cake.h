@@ -7,11 +7,47 @@
 #define PILE_NAME_MAXLEN 20
 
 #define PILE_ALIGN_CACHE 1
+#define PILE_NO_MAGAZINE 2
 
 struct cake_pile;
 
 typedef void (*pile_cb)(struct cake_pile*, void*);
 
+/**
+ * @brief 弹匣：一叠已归还但仍然保持切好的蛋糕块儿，
+ *        可以不经过蛋糕本身直接拿走或放回
+ *
+ */
+struct cake_mag
+{
+    struct llist_header mags;
+    unsigned int rounds;
+    void* pieces[CONFIG_CAKE_MAG_ROUNDS];
+};
+
+/**
+ * @brief 每个CPU私有的一对弹匣 (loaded/previous)，
+ *        只在本地中断关闭时访问，因此无需加锁
+ *
+ */
+struct cake_cpu_cache
+{
+    struct cake_mag* loaded;
+    struct cake_mag* previous;
+};
+
+/**
+ * @brief 弹匣仓库：在各个CPU之间共享的满/空弹匣
+ *
+ */
+struct cake_depot
+{
+    struct llist_header full;
+    struct llist_header empty;
+    unsigned int nr_full;
+    unsigned int nr_empty;
+};
+
 struct cake_pile
 {
     struct llist_header piles;
@@ -26,6 +62,15 @@ struct cake_pile
     u32_t pg_per_cake;
     char pile_name[PILE_NAME_MAXLEN+1];
 
+    int options;
+    // served by (or returned to) magazines, or fall through to cakes
+    u32_t grab_hits;
+    u32_t grab_misses;
+    u32_t release_hits;
+    u32_t release_misses;
+    struct cake_cpu_cache cpu_caches[CONFIG_NR_CPUS];
+    struct cake_depot depot;
+
     pile_cb ctor;
 };
 
@@ -77,6 +122,15 @@ cake_grab(struct cake_pile* pile);
 int
 cake_release(struct cake_pile* pile, void* area);
 
+/**
+ * @brief 查找一块儿蛋糕所属的蛋糕堆，O(1)
+ *
+ * @param area
+ * @return struct cake_pile* 若不属于任何蛋糕堆，返回NULL
+ */
+struct cake_pile*
+cake_pile_of(void* area);
+
 void
 cake_init();
 
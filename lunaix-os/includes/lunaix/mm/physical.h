@@ -23,6 +23,8 @@
 #define PP_RESERVED     0b1000
 
 struct ppage_arch;
+struct cake_pile;
+struct cake_s;
 
 struct ppage
 {
@@ -45,7 +47,16 @@ struct ppage
     };
     unsigned short companion;
     
-    struct llist_header sibs;
+    union {
+        // linkage in allocator's idle list, only valid when page is free
+        struct llist_header sibs;
+
+        // owner of a cake, only valid on the lead page of a cake
+        struct {
+            struct cake_pile* pile;
+            struct cake_s* cake;
+        } cake;
+    };
 
     struct ppage_arch arch;
 } align(16);
@@ -19,11 +19,29 @@ typedef unsigned int ppage_type_t;
 
 #define RESERVE_MARKER 0xf0f0f0f0
 
+/**
+ * @brief Running counters of a pool, maintained by allocator backend
+ *
+ */
+struct pmem_stats
+{
+    // leaflets currently handed out, per order
+    unsigned int busy[MAX_PAGE_ORDERS + 1];
+    // pages put on hold (reserved)
+    unsigned int reserved;
+    // allocation requests that can not be satisfied
+    unsigned int failed;
+    // number of linear scans, and pages visited by them
+    unsigned int scans;
+    unsigned int scan_pages;
+};
+
 struct pmem_pool
 {
     int type;
     struct ppage* pool_start;
     struct ppage* pool_end;
+    struct pmem_stats stats;
     
 #if defined(CONFIG_PMALLOC_NCONTIG)
 
@@ -32,12 +50,13 @@ struct pmem_pool
     
 #elif defined(CONFIG_PMALLOC_BUDDY)
 
-    struct llist_header idle_order[MAX_PAGE_ORDERS];
+    struct llist_header idle_order[MAX_PAGE_ORDERS + 1];
+    int count[MAX_PAGE_ORDERS + 1];
     
 #elif defined(CONFIG_PMALLOC_SIMPLE)
 
-    struct llist_header idle_order[MAX_PAGE_ORDERS];
-    int count[MAX_PAGE_ORDERS];
+    struct llist_header idle_order[MAX_PAGE_ORDERS + 1];
+    int count[MAX_PAGE_ORDERS + 1];
 
 #endif
 };
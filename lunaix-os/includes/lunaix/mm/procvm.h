@@ -36,8 +36,15 @@ struct proc_mm
     vm_regions_t      regions;
 
     struct mm_region* heap;
+    struct mm_region* vdso;
     struct proc_info* proc;
     struct proc_mm*   guest_mm;     // vmspace mounted by this vmspace
+
+    struct {
+        u32_t faults;           // page faults on user regions
+        u32_t file_faults;      // ... of which on file-backed region
+        u32_t mapped_around;    // pages mapped by fault-around
+    } stats;
 };
 
 /**
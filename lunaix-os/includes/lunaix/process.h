@@ -65,11 +65,18 @@ struct proc_sig
 
 
 struct proc_info;
+struct sched_runq;
 
 struct haybed {
-    struct llist_header sleepers;
-    time_t wakeup_time;
-    time_t alarm_time;
+    struct lx_timer wakeup;
+    struct lx_timer alarm;
+    struct lx_timer timeout; // bounds a blocking syscall, set up by its user
+};
+
+struct runq_node {
+    struct llist_header sibs;
+    struct sched_runq* rq;
+    int level;
 };
 
 struct thread
@@ -100,6 +107,7 @@ struct thread
     };
 
     struct haybed sleep;
+    struct runq_node schedq;        // position in scheduler run queue
 
     struct proc_info* process;
     struct llist_header proc_sibs;  // sibling to process-local threads
@@ -130,6 +138,7 @@ struct proc_info
 
         int state;
         int exit_code;
+        int nice;
     };
 
     struct proc_mm* mm;
@@ -153,7 +162,6 @@ extern volatile struct thread* current_thread;
  */
 #define kernel_process(proc) (!(proc)->pid)
 
-#define resume_thread(th) (th)->state = PS_READY
 #define pause_thread(th) (th)->state = PS_PAUSED
 #define block_thread(th) (th)->state = PS_BLOCKED
 
@@ -189,6 +197,14 @@ procvm_asid(struct proc_mm* mm)
     return mm->proc->pid;
 }
 
+/**
+ * @brief Mark the thread as ready and put it onto the scheduler run queue
+ *
+ * @param thread
+ */
+void
+resume_thread(struct thread* thread);
+
 static inline void
 block_current_thread()
 {
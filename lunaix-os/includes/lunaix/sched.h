@@ -10,12 +10,36 @@
 #define PROC_TABLE_SIZE 8192
 #define MAX_PROCESS (PROC_TABLE_SIZE / sizeof(ptr_t))
 
+#define SCHED_NICE_MIN -20
+#define SCHED_NICE_MAX 19
+#define SCHED_PRIO_LEVELS (SCHED_NICE_MAX - SCHED_NICE_MIN + 1)
+#define SCHED_BITMAP_LEN ((SCHED_PRIO_LEVELS + 31) / 32)
+
+/*
+    Priority run queue. Each level is a FIFO of ready threads, a set
+    bit in bitmap marks a non-empty level. Lower level is preferred.
+*/
+struct sched_runq
+{
+    u32_t bitmap[SCHED_BITMAP_LEN];
+    struct llist_header levels[SCHED_PRIO_LEVELS];
+    int nr_ready;
+};
+
 struct scheduler
 {
     struct proc_info** procs;
     struct llist_header* threads;
     struct llist_header* proc_list;
-    struct llist_header sleepers;
+
+    /*
+        Threads that woken up or newly created go to active, threads
+        that used up their turn go to expired. Two are swapped once
+        active running dry, so every ready thread gets its turn.
+    */
+    struct sched_runq runqs[2];
+    struct sched_runq* active;
+    struct sched_runq* expired;
 
     int procs_index;
     int ptable_len;
@@ -37,4 +61,32 @@ run(struct thread* thread);
 void
 cleanup_detached_threads();
 
+/**
+ * @brief Number of threads queued for running, excluding the
+ *        current one.
+ *
+ */
+int
+sched_nr_ready();
+
+/**
+ * @brief Put thread onto run queue without altering its state, so
+ *        its runnability will be re-evaluated on next schedule.
+ *        (e.g., a pending signal may awake a paused thread)
+ *
+ * @param thread
+ */
+void
+sched_recheck(struct thread* thread);
+
+/**
+ * @brief Time slice (in millisecond) granted to thread upon each
+ *        schedule, scaled by its priority.
+ *
+ * @param thread
+ * @return time_t
+ */
+time_t
+sched_timeslice(struct thread* thread);
+
 #endif /* __LUNAIX_SCHEDULER_H */
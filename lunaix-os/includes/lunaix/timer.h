@@ -8,10 +8,17 @@
 #define SYS_TIMER_FREQUENCY_HZ 1000
 
 #define TIMER_MODE_PERIODIC 0x1
+#define TIMER_AUTOFREE 0x2
 
 struct lx_timer_context
 {
-    struct lx_timer* active_timers;
+    /**
+     * @brief Armed timers, organized as binary min-heap on deadline
+     *
+     */
+    struct lx_timer** timers;
+    unsigned int nr_timers;
+    unsigned int capacity;
     /**
      * @brief timer hardware base frequency (ticks per seconds)
      *
@@ -37,11 +44,19 @@ struct timer_init_param
 
 struct lx_timer
 {
-    struct llist_header link;
+    /**
+     * @brief absolute systicks when the timer expires
+     *
+     */
     ticks_t deadline;
-    ticks_t counter;
+    ticks_t interval;
     void* payload;
     void (*callback)(void*);
+    /**
+     * @brief 1-based position in timer heap, 0 if not armed
+     *
+     */
+    unsigned int heap_idx;
     u8_t flags;
 };
 
@@ -68,6 +83,73 @@ timer_run_ms(u32_t millisecond,
 struct lx_timer*
 timer_run(ticks_t ticks, void (*callback)(void*), void* payload, u8_t flags);
 
+/**
+ * @brief Setup a caller owned timer. It can then be (re-)armed 
+ *        with timer_arm without any allocation.
+ *
+ */
+void
+timer_setup(struct lx_timer* timer,
+            void (*callback)(void*),
+            void* payload,
+            u8_t flags);
+
+/**
+ * @brief Arm the timer to expire after given ticks, re-arming an
+ *        armed timer will override the previous deadline.
+ *
+ * @return 0, or ENOMEM if the timer heap can not grow to take it, in
+ *         which case the timer is left unarmed.
+ */
+int
+timer_arm(struct lx_timer* timer, ticks_t ticks);
+
+/**
+ * @brief Disarm the timer, it is a no-op if timer is not armed.
+ *
+ */
+void
+timer_disarm(struct lx_timer* timer);
+
+/**
+ * @brief Disarm and release a timer obtained from timer_run*.
+ *
+ */
+void
+timer_cancel(struct lx_timer* timer);
+
+/**
+ * @brief Ticks left before timer expires, 0 if not armed.
+ *
+ */
+ticks_t
+timer_remaining(struct lx_timer* timer);
+
+/**
+ * @brief Get the earliest deadline among all armed timers.
+ *
+ * @param deadline absolute systicks of the earliest deadline
+ * @return whether there is any armed timer
+ */
+bool
+timer_next_deadline(ticks_t* deadline);
+
+/**
+ * @brief Halt the processor until next interrupt. The periodic tick
+ *        is suppressed until the earliest timer deadline, provided 
+ *        that the hardware timer supports oneshot. Returns right
+ *        away if any thread is ready to run.
+ *
+ */
+void
+timer_idle();
+
+static inline bool
+timer_armed(struct lx_timer* timer)
+{
+    return !!timer->heap_idx;
+}
+
 struct lx_timer_context*
 timer_context();
 
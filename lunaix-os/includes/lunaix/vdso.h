@@ -0,0 +1,26 @@
+#ifndef __LUNAIX_VDSO_H
+#define __LUNAIX_VDSO_H
+
+#include <lunaix/mm/procvm.h>
+#include <lunaix/process.h>
+
+#include <usr/lunaix/vdso.h>
+
+/**
+ * @brief Map the vdso page into `mm`, or keep the one already there.
+ *
+ * @return ptr_t user address of the page, 0 if failed
+ */
+ptr_t
+vdso_map(struct proc_mm* mm, ptr_t vm_mnt);
+
+/**
+ * @brief Refresh the volatile part of the vdso page that `thread` sees.
+ * Called on every tick and every switch, since only the running thread
+ * can read it.
+ *
+ */
+void
+vdso_update(struct thread* thread);
+
+#endif /* __LUNAIX_VDSO_H */
@@ -10,6 +10,7 @@
 #define FO_WRONLY 0x8
 #define FO_RDONLY 0x10
 #define FO_RDWR 0x20
+#define FO_NONBLOCK 0x40
 
 #define FO_NOFOLLOW 0x10000
 
@@ -23,6 +24,7 @@
 #define O_WRONLY FO_WRONLY
 #define O_RDONLY FO_RDONLY
 #define O_RDWR FO_RDWR
+#define O_NONBLOCK FO_NONBLOCK
 
 #define MNT_RO 0x1
 
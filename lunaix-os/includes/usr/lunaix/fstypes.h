@@ -7,6 +7,7 @@
 #define F_SEQDEV 0x6
 #define F_VOLDEV 0xa
 #define F_SYMLINK 0x10
+#define F_PIPE 0x20
 
 #define F_MFILE 0b00001
 #define F_MDEV 0b01110
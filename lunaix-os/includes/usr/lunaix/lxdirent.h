@@ -5,4 +5,6 @@
 
 int sys_readdir(int fd, struct lx_dirent* dirent);
 
+int sys_getdents(int fd, struct lx_dirent* dirents, unsigned int count);
+
 #endif /* __LUNAIX_DIRENT_H */
@@ -35,5 +35,9 @@
 #define ELIBBAD -29
 #define EAGAIN -30
 #define EDEADLK -31
+#define ENOSPC -32
+#define EPIPE -33
+#define ETIMEDOUT -34
+#define EPERM -35
 
 #endif /* __LUNAIX_STATUS_H */
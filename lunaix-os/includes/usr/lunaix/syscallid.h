@@ -74,6 +74,19 @@
 #define __SYSCALL_th_detach 62
 #define __SYSCALL_th_sigmask 63
 
+#define __SYSCALL_nice 64
+
+#define __SYSCALL_sys_getdents 65
+
+#define __SYSCALL_clock_gettime 66
+
+#define __SYSCALL_pipe 67
+#define __SYSCALL_pipe2 68
+
+#define __SYSCALL_futex 69
+
+#define __SYSCALL_ftruncate 70
+
 #define __SYSCALL_MAX 0x100
 
 #endif /* __LUNAIX_SYSCALLID_H */
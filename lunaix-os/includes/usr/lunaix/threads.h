@@ -3,6 +3,9 @@
 
 #include "types.h"
 
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
 struct uthread_info {
     void* th_stack_top;
     size_t th_stack_sz;
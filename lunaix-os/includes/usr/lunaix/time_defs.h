@@ -0,0 +1,13 @@
+#ifndef __LUNAIX_USR_TIME_DEFS_H
+#define __LUNAIX_USR_TIME_DEFS_H
+
+#define CLOCK_REALTIME 0  // nanoseconds since unix epoch
+#define CLOCK_MONOTONIC 1 // nanoseconds since boot, never goes backward
+
+struct timespec
+{
+    unsigned int tv_sec;
+    unsigned int tv_nsec;
+};
+
+#endif /* __LUNAIX_USR_TIME_DEFS_H */
@@ -0,0 +1,23 @@
+#ifndef __LUNAIX_USR_VDSO_H
+#define __LUNAIX_USR_VDSO_H
+
+#include "types.h"
+
+/*
+    A read-only page kernel maps into every process, its address is
+    handed to the program entry along with argv and envp.
+
+    Kernel makes `seq` odd while updating, reader should retry if it
+    read an odd `seq` or a different one afterwards.
+*/
+struct lx_vdso
+{
+    volatile unsigned int seq;
+    unsigned int tick_freq;     // systicks per second
+    unsigned int systicks;      // systicks since boot
+    unsigned int epoch;         // unix time at boot
+    pid_t pid;
+    tid_t tid;                  // the thread currently running
+};
+
+#endif /* __LUNAIX_USR_VDSO_H */
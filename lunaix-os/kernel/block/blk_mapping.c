@@ -46,6 +46,14 @@ __blk_rd_size(struct twimap* map)
       map, "%u", (u32_t)(bdev->end_lba - bdev->start_lba) * bdev->blk_size);
 }
 
+void
+__blk_rd_io_stats(struct twimap* map)
+{
+    struct block_dev* bdev = twimap_data(map, struct block_dev*);
+    struct blkio_context* ctx = bdev->blkio;
+    twimap_printf(map, "%u %u", ctx->stats.dispatched, ctx->stats.merged);
+}
+
 void
 __map_internal(struct block_dev* bdev, void* fsnode)
 {
@@ -65,6 +73,9 @@ __map_internal(struct block_dev* bdev, void* fsnode)
 
     map = twifs_mapping(dev_root, bdev, "end");
     map->read = __blk_rd_end_lba;
+
+    map = twifs_mapping(dev_root, bdev, "io_stats");
+    map->read = __blk_rd_io_stats;
 }
 
 void
@@ -1,10 +1,16 @@
 #include <lunaix/blkio.h>
 #include <lunaix/mm/cake.h>
 #include <lunaix/mm/valloc.h>
+#include <lunaix/process.h>
+#include <lunaix/spike.h>
 
 #include <sys/cpu.h>
 
+// upper bound of the size of a merged request
+#define BLKIO_MERGE_MAXSZ (128 * 1024)
+
 static struct cake_pile* blkio_reqpile;
+static struct blkio_plug* active_plug;
 
 void
 blkio_init()
@@ -26,6 +32,8 @@ __blkio_req_create(struct vecbuf* buffer,
                                 .flags = options,
                                 .evt_args = evt_args };
     breq->vbuf = buffer;
+    llist_init_head(&breq->sched_link);
+    llist_init_head(&breq->merged);
     waitq_init(&breq->wait);
     return breq;
 }
@@ -65,18 +73,93 @@ blkio_newctx(req_handler handler)
     struct blkio_context* ctx =
       (struct blkio_context*)vzalloc(sizeof(struct blkio_context));
     ctx->handle_one = handler;
+    ctx->depth = 1;
+    ctx->max_segs = 1;
+    ctx->blk_size = 512;
+    ctx->sched = &blkio_sched_deadline;
 
     llist_init_head(&ctx->queue);
+    llist_init_head(&ctx->expiry);
 
     return ctx;
 }
 
+void
+blkio_set_sched(struct blkio_context* ctx, const struct blkio_sched* sched)
+{
+    assert(llist_empty(&ctx->queue));
+    ctx->sched = sched;
+}
+
+static bool
+__blkio_plug_hold(struct blkio_context* ctx)
+{
+    struct blkio_plug* plug = active_plug;
+
+    if (!plug || plug->owner != current_thread) {
+        return false;
+    }
+
+    for (u32_t i = 0; i < plug->nr_held; i++) {
+        if (plug->held[i] == ctx) {
+            return true;
+        }
+    }
+
+    if (plug->nr_held == BLKIO_PLUG_MAXCTX) {
+        return false;
+    }
+
+    plug->held[plug->nr_held++] = ctx;
+    return true;
+}
+
+void
+blkio_plug(struct blkio_plug* plug)
+{
+    u32_t intr = cpu_save_interrupt();
+
+    plug->owner = NULL;
+    plug->nr_held = 0;
+
+    if (!active_plug) {
+        plug->owner = current_thread;
+        active_plug = plug;
+    }
+
+    cpu_restore_interrupt(intr);
+}
+
+void
+blkio_unplug(struct blkio_plug* plug)
+{
+    struct blkio_context* ctx;
+    u32_t intr = cpu_save_interrupt();
+
+    if (active_plug == plug) {
+        active_plug = NULL;
+
+        for (u32_t i = 0; i < plug->nr_held; i++) {
+            ctx = plug->held[i];
+            if (ctx->busy < ctx->depth) {
+                blkio_schedule(ctx);
+            }
+        }
+    }
+
+    cpu_restore_interrupt(intr);
+}
+
 void
 blkio_commit(struct blkio_context* ctx, struct blkio_req* req, int options)
 {
+    // we may be called from preemptible kernel thread, keep the queue
+    //  consistent.
+    u32_t intr = cpu_save_interrupt();
+
     req->flags |= BLKIO_PENDING;
     req->io_ctx = ctx;
-    llist_append(&ctx->queue, &req->reqs);
+    ctx->sched->enqueue(ctx, req);
 
     // if the pipeline is not running (e.g., stalling). Then we should schedule
     // one immediately and kick it started.
@@ -89,37 +172,175 @@ blkio_commit(struct blkio_context* ctx, struct blkio_req* req, int options)
     // As we don't want to overwhelming the interrupt context and also keep the
     // request RTT as small as possible, hence #1 is preferred.
 
-    if (!ctx->busy) {
-        if ((options & BLKIO_WAIT)) {
-            cpu_disable_interrupt();
+    // held back by plug, the batch is dispatched (and merged) on unplug.
+    if ((options & BLKIO_WAIT) || !__blkio_plug_hold(ctx)) {
+        if (ctx->busy < ctx->depth) {
             blkio_schedule(ctx);
-            pwait(&req->wait);
-            return;
         }
-        blkio_schedule(ctx);
-    } else if ((options & BLKIO_WAIT)) {
+    }
+
+    if ((options & BLKIO_WAIT) && (req->flags & BLKIO_PENDING)) {
         pwait(&req->wait);
+        return;
     }
+
+    cpu_restore_interrupt(intr);
 }
 
-void
-blkio_schedule(struct blkio_context* ctx)
+static inline void
+__blkio_unqueue(struct blkio_req* req)
 {
-    if (llist_empty(&ctx->queue)) {
-        return;
+    llist_delete(&req->reqs);
+    llist_delete(&req->sched_link);
+}
+
+static inline size_t
+__blkio_nr_segs(struct blkio_req* req)
+{
+    size_t n = 0;
+    struct vecbuf *pos, *n_;
+
+    llist_for_each(pos, n_, &req->vbuf->components, components)
+    {
+        n++;
+    }
+
+    return n + 1;
+}
+
+static inline bool
+__blkio_mergeable(struct blkio_req* a, struct blkio_req* b)
+{
+    return !((a->flags ^ b->flags) & BLKIO_WRITE) &&
+           !(vbuf_size(b->vbuf) % b->io_ctx->blk_size);
+}
+
+/**
+ * @brief Absorb all queued requests that are physically adjacent to `req`,
+ * either in front or behind. The absorbed requests are chained as members
+ * of a composite request which is then handed to driver as a whole.
+ *
+ * @return struct blkio_req* either `req` itself or the composite
+ */
+static struct blkio_req*
+__blkio_merge(struct blkio_context* ctx, struct blkio_req* req)
+{
+    struct blkio_req *pos, *n, *composite;
+    struct vecbuf *buf, *buf_n, *vbuf = NULL;
+    u64_t start, end;
+    size_t segs, size;
+    bool absorbed;
+
+    if (ctx->max_segs < 2 || !ctx->blk_size ||
+        (vbuf_size(req->vbuf) % ctx->blk_size)) {
+        return req;
+    }
+
+    start = req->blk_addr;
+    end = start + blkio_nr_blocks(req);
+    segs = __blkio_nr_segs(req);
+    size = vbuf_size(req->vbuf);
+
+    llist_init_head(&req->merged);
+
+    do {
+        absorbed = false;
+        llist_for_each(pos, n, &ctx->queue, reqs)
+        {
+            if (!__blkio_mergeable(req, pos)) {
+                continue;
+            }
+
+            if (segs + __blkio_nr_segs(pos) > ctx->max_segs ||
+                size + vbuf_size(pos->vbuf) > BLKIO_MERGE_MAXSZ) {
+                continue;
+            }
+
+            if (pos->blk_addr == end) {
+                // back merge
+                __blkio_unqueue(pos);
+                llist_append(&req->merged, &pos->reqs);
+                end += blkio_nr_blocks(pos);
+            } else if (pos->blk_addr + blkio_nr_blocks(pos) == start) {
+                // front merge
+                __blkio_unqueue(pos);
+                llist_prepend(&req->merged, &pos->reqs);
+                start = pos->blk_addr;
+            } else {
+                continue;
+            }
+
+            segs += __blkio_nr_segs(pos);
+            size += vbuf_size(pos->vbuf);
+            ctx->stats.merged++;
+            absorbed = true;
+        }
+    } while (absorbed);
+
+    if (llist_empty(&req->merged)) {
+        return req;
+    }
+
+    // put req itself in place, members are kept in lba order
+    llist_for_each(pos, n, &req->merged, reqs)
+    {
+        if (pos->blk_addr > req->blk_addr) {
+            break;
+        }
     }
+    llist_append(&pos->reqs, &req->reqs);
+
+    composite = (struct blkio_req*)cake_grab(blkio_reqpile);
+    *composite = (struct blkio_req){ .blk_addr = start,
+                                     .io_ctx = ctx,
+                                     .flags = (req->flags & BLKIO_WRITE) |
+                                              BLKIO_MERGED | BLKIO_PENDING };
+    llist_init_head(&composite->sched_link);
+    waitq_init(&composite->wait);
+
+    // take over the member list
+    llist_init_head(&composite->merged);
+    llist_append(&req->merged, &composite->merged);
+    llist_delete(&req->merged);
 
-    struct blkio_req* head = (struct blkio_req*)ctx->queue.next;
-    llist_delete(&head->reqs);
+    llist_for_each(pos, n, &composite->merged, reqs)
+    {
+        pos->flags |= BLKIO_BUSY;
 
-    head->flags |= BLKIO_BUSY;
-    head->io_ctx->busy++;
+        buf = pos->vbuf;
+        vbuf_alloc(&vbuf, buf->buf.buffer, buf->buf.size);
+        llist_for_each(buf, buf_n, &pos->vbuf->components, components)
+        {
+            vbuf_alloc(&vbuf, buf->buf.buffer, buf->buf.size);
+        }
+    }
 
-    ctx->handle_one(head);
+    composite->vbuf = vbuf;
+    return composite;
 }
 
 void
-blkio_complete(struct blkio_req* req)
+blkio_schedule(struct blkio_context* ctx)
+{
+    struct blkio_req* head;
+
+    while (!llist_empty(&ctx->queue) && ctx->busy < ctx->depth) {
+        head = ctx->sched->pick(ctx);
+        __blkio_unqueue(head);
+
+        head = __blkio_merge(ctx, head);
+
+        head->flags |= BLKIO_BUSY;
+        ctx->head_pos = head->blk_addr + blkio_nr_blocks(head);
+        ctx->busy++;
+        ctx->stats.dispatched++;
+
+        ctx->handle_one(head);
+    }
+}
+
+static void
+__blkio_finish(struct blkio_req* req)
 {
     req->flags &= ~(BLKIO_BUSY | BLKIO_PENDING);
 
@@ -134,6 +355,32 @@ blkio_complete(struct blkio_req* req)
     if ((req->flags & BLKIO_FOC)) {
         blkio_free_req(req);
     }
+}
 
-    req->io_ctx->busy--;
-}
\ No newline at end of file
+void
+blkio_complete(struct blkio_req* req)
+{
+    struct blkio_context* ctx = req->io_ctx;
+    struct blkio_req *pos, *n;
+
+    if (!(req->flags & BLKIO_MERGED)) {
+        __blkio_finish(req);
+        ctx->busy--;
+        return;
+    }
+
+    llist_for_each(pos, n, &req->merged, reqs)
+    {
+        llist_delete(&pos->reqs);
+
+        pos->errcode = req->errcode;
+        pos->flags |= (req->flags & BLKIO_ERROR);
+
+        __blkio_finish(pos);
+    }
+
+    vbuf_free(req->vbuf);
+    blkio_free_req(req);
+
+    ctx->busy--;
+}
@@ -0,0 +1,168 @@
+#include <lunaix/blkio.h>
+#include <lunaix/clock.h>
+
+/*
+    The scheduling policies only decide which of the queued requests is to be
+    served next. Merging of adjacent requests is done by blkio core upon
+    dispatching, thus available to all policies.
+*/
+
+// request expiration in ms, reads are favoured as someone is usually waiting
+#define DEADLINE_READ_EXPIRE 500
+#define DEADLINE_WRITE_EXPIRE 5000
+
+// in blocks, a head movement within this is taken as track-to-track,
+//  costing mostly the rotation rather than a full seek.
+#define SHORT_SEEK_BLOCKS 2048U
+
+/**
+ * @brief Estimated time (ms) to position the head from where the last
+ *        dispatch left it onto `req`. It is zero for a request that just
+ *        continues the previous one, or for devices without moving parts.
+ */
+static u32_t
+__position_cost(struct blkio_context* ctx, struct blkio_req* req)
+{
+    u64_t dist;
+
+    if (req->blk_addr == ctx->head_pos) {
+        return 0;
+    }
+
+    dist = req->blk_addr > ctx->head_pos ? req->blk_addr - ctx->head_pos
+                                         : ctx->head_pos - req->blk_addr;
+
+    if (dist < SHORT_SEEK_BLOCKS) {
+        return ctx->metrics.rotdelay;
+    }
+
+    return ctx->metrics.seektime + ctx->metrics.rotdelay;
+}
+
+static void
+__fifo_enqueue(struct blkio_context* ctx, struct blkio_req* req)
+{
+    llist_append(&ctx->queue, &req->reqs);
+}
+
+static struct blkio_req*
+__fifo_pick(struct blkio_context* ctx)
+{
+    return list_entry(ctx->queue.next, struct blkio_req, reqs);
+}
+
+/*
+    Elevator (C-LOOK): queue is kept sorted by lba, the head sweeps toward
+    higher lba and jump back to the lowest pending one once hitting the end.
+
+    A request just behind the head is taken ahead of the sweep if reaching
+    it costs less than what the sweep would, i.e. a short hop back saves a
+    full seek.
+
+    Sorting make no sense on devices without moving parts, we fall back to
+    fifo order for those.
+*/
+
+static void
+__elevator_enqueue(struct blkio_context* ctx, struct blkio_req* req)
+{
+    struct blkio_req *pos, *n;
+
+    if (!blkio_rotational(ctx)) {
+        __fifo_enqueue(ctx, req);
+        return;
+    }
+
+    llist_for_each(pos, n, &ctx->queue, reqs)
+    {
+        if (pos->blk_addr > req->blk_addr) {
+            break;
+        }
+    }
+
+    // insert before the first one that is further away.
+    llist_append(&pos->reqs, &req->reqs);
+}
+
+static struct blkio_req*
+__elevator_pick(struct blkio_context* ctx)
+{
+    struct blkio_req *pos, *n, *behind = NULL;
+
+    if (!blkio_rotational(ctx)) {
+        return __fifo_pick(ctx);
+    }
+
+    llist_for_each(pos, n, &ctx->queue, reqs)
+    {
+        if (pos->blk_addr >= ctx->head_pos) {
+            break;
+        }
+        behind = pos;
+    }
+
+    if (&pos->reqs == &ctx->queue) {
+        // wrap around
+        return __fifo_pick(ctx);
+    }
+
+    if (behind &&
+        __position_cost(ctx, behind) < __position_cost(ctx, pos)) {
+        return behind;
+    }
+
+    return pos;
+}
+
+/*
+    Deadline: elevator order in general, but a request that waited beyond
+    its expiration is served right away to prevent starvation. Expiration
+    is brought forward by the time needed to reach the request, so that it
+    gets served by, rather than after, the deadline.
+*/
+
+static void
+__deadline_enqueue(struct blkio_context* ctx, struct blkio_req* req)
+{
+    time_t expire = (req->flags & BLKIO_WRITE) ? DEADLINE_WRITE_EXPIRE
+                                               : DEADLINE_READ_EXPIRE;
+
+    req->deadline = clock_systime() + expire;
+    llist_append(&ctx->expiry, &req->sched_link);
+
+    __elevator_enqueue(ctx, req);
+}
+
+static struct blkio_req*
+__deadline_pick(struct blkio_context* ctx)
+{
+    struct blkio_req* oldest;
+
+    if (!llist_empty(&ctx->expiry)) {
+        oldest = list_entry(ctx->expiry.next, struct blkio_req, sched_link);
+        if (oldest->deadline <=
+            clock_systime() + __position_cost(ctx, oldest)) {
+            return oldest;
+        }
+    }
+
+    return __elevator_pick(ctx);
+}
+
+const struct blkio_sched blkio_sched_fifo = {
+    .name = "fifo",
+    .enqueue = __fifo_enqueue,
+    .pick = __fifo_pick,
+};
+
+const struct blkio_sched blkio_sched_elevator = {
+    .name = "elevator",
+    .enqueue = __elevator_enqueue,
+    .pick = __elevator_pick,
+};
+
+const struct blkio_sched blkio_sched_deadline = {
+    .name = "deadline",
+    .enqueue = __deadline_enqueue,
+    .pick = __deadline_pick,
+};
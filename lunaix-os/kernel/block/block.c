@@ -149,21 +149,31 @@ __block_write(struct device* dev, void* buf, size_t offset, size_t len)
     return errno;
 }
 
+/**
+ * @brief Number of blocks, of the page starting at `lba`, that lie within
+ *        the device. Note that `end_lba` is inclusive.
+ */
+static inline u32_t
+__block_page_span(struct block_dev* bdev, u64_t lba)
+{
+    u64_t end = MIN(lba + PAGE_SIZE / bdev->blk_size, bdev->end_lba + 1);
+
+    return end > lba ? (u32_t)(end - lba) : 0;
+}
+
 int
 __block_read_page(struct device* dev, void* buf, size_t offset)
 {
     struct vecbuf* vbuf = NULL;
     struct block_dev* bdev = (struct block_dev*)dev->underlay;
 
-    u32_t lba = offset / bdev->blk_size + bdev->start_lba;
-    u32_t rd_lba = MIN(lba + PAGE_SIZE / bdev->blk_size, bdev->end_lba);
+    u64_t lba = offset / bdev->blk_size + bdev->start_lba;
+    u32_t rd_lba = __block_page_span(bdev, lba);
 
-    if (rd_lba <= lba) {
+    if (!rd_lba) {
         return 0;
     }
 
-    rd_lba -= lba;
-
     vbuf_alloc(&vbuf, buf, rd_lba * bdev->blk_size);
 
     struct blkio_req* req = blkio_vrd(vbuf, lba, NULL, NULL, 0);
@@ -176,20 +186,71 @@ __block_read_page(struct device* dev, void* buf, size_t offset)
     return errno;
 }
 
+struct block_aio
+{
+    devio_done_cb done;
+    void* arg;
+    size_t len;
+};
+
+static void
+__block_aio_done(struct blkio_req* req)
+{
+    struct block_aio* aio = (struct block_aio*)req->evt_args;
+    int result = req->errcode ? -req->errcode : (int)aio->len;
+
+    aio->done(aio->arg, result);
+
+    vbuf_free(req->vbuf);
+    vfree(aio);
+}
+
 int
-__block_write_page(struct device* dev, void* buf, size_t offset)
+__block_read_page_async(struct device* dev,
+                        void* buf,
+                        off_t offset,
+                        devio_done_cb done,
+                        void* arg)
 {
     struct vecbuf* vbuf = NULL;
+    struct block_aio* aio;
+    size_t len;
     struct block_dev* bdev = (struct block_dev*)dev->underlay;
 
-    u32_t lba = offset / bdev->blk_size + bdev->start_lba;
-    u32_t wr_lba = MIN(lba + PAGE_SIZE / bdev->blk_size, bdev->end_lba);
+    u64_t lba = offset / bdev->blk_size + bdev->start_lba;
+    u32_t rd_lba = __block_page_span(bdev, lba);
 
-    if (wr_lba <= lba) {
+    if (!rd_lba) {
         return 0;
     }
+    len = rd_lba * bdev->blk_size;
 
-    wr_lba -= lba;
+    aio = valloc(sizeof(struct block_aio));
+    *aio = (struct block_aio){ .done = done, .arg = arg, .len = len };
+
+    vbuf_alloc(&vbuf, buf, len);
+
+    struct blkio_req* req =
+      blkio_vrd(vbuf, lba, __block_aio_done, aio, BLKIO_FOC);
+
+    // aio is not ours anymore once committed
+    blkio_commit(bdev->blkio, req, 0);
+
+    return len;
+}
+
+int
+__block_write_page(struct device* dev, void* buf, size_t offset)
+{
+    struct vecbuf* vbuf = NULL;
+    struct block_dev* bdev = (struct block_dev*)dev->underlay;
+
+    u64_t lba = offset / bdev->blk_size + bdev->start_lba;
+    u32_t wr_lba = __block_page_span(bdev, lba);
+
+    if (!wr_lba) {
+        return 0;
+    }
 
     vbuf_alloc(&vbuf, buf, wr_lba * bdev->blk_size);
 
@@ -203,6 +264,63 @@ __block_write_page(struct device* dev, void* buf, size_t offset)
     return errno;
 }
 
+typedef struct blkio_req* (*blkio_mkreq)(struct vecbuf*,
+                                         u64_t,
+                                         blkio_cb,
+                                         void*,
+                                         u32_t);
+
+static int
+__block_xfer_vec(struct device* dev,
+                 struct vecbuf* pages,
+                 off_t offset,
+                 blkio_mkreq mkreq)
+{
+    struct block_dev* bdev = (struct block_dev*)dev->underlay;
+    struct vecbuf *pos = pages, *chunk;
+    struct blkio_req* req;
+    size_t bsize = bdev->blk_size;
+    u64_t lba = offset / bsize + bdev->start_lba;
+    u32_t segs;
+    int errno;
+
+    if (lba + vbuf_size(pages) / bsize > (u64_t)bdev->end_lba + 1) {
+        return EINVAL;
+    }
+
+    // split into pieces that driver can take in one command.
+    do {
+        chunk = NULL;
+        segs = 0;
+
+        do {
+            vbuf_alloc(&chunk, pos->buf.buffer, pos->buf.size);
+            pos = list_entry(pos->components.next, struct vecbuf, components);
+        } while (pos != pages && ++segs < bdev->blkio->max_segs);
+
+        req = mkreq(chunk, lba, NULL, NULL, 0);
+        lba += vbuf_size(chunk) / bsize;
+
+        if ((errno = __block_commit(bdev->blkio, req, BLKIO_WAIT))) {
+            return errno;
+        }
+    } while (pos != pages);
+
+    return vbuf_size(pages);
+}
+
+int
+__block_write_pages(struct device* dev, struct vecbuf* pages, off_t offset)
+{
+    return __block_xfer_vec(dev, pages, offset, blkio_vwr);
+}
+
+int
+__block_read_pages(struct device* dev, struct vecbuf* pages, off_t offset)
+{
+    return __block_xfer_vec(dev, pages, offset, blkio_vrd);
+}
+
 int
 __block_rd_lb(struct block_dev* bdev, void* buf, u64_t start, size_t count)
 {
@@ -269,6 +387,8 @@ block_mount(struct block_dev* bdev, devfs_exporter fs_export)
 {
     int errno = 0;
 
+    bdev->blkio->blk_size = bdev->blk_size;
+
     if (!__block_register(bdev)) {
         errno = BLOCK_EFULL;
         goto error;
@@ -304,6 +424,9 @@ __block_register(struct block_dev* bdev)
     dev->ops.write_page = __block_write_page;
     dev->ops.read = __block_read;
     dev->ops.read_page = __block_read_page;
+    dev->ops.read_page_async = __block_read_page_async;
+    dev->ops.write_pages = __block_write_pages;
+    dev->ops.read_pages = __block_read_pages;
 
     bdev->dev = dev;
 
@@ -330,6 +453,9 @@ blk_mount_part(struct block_dev* bdev,
     dev->ops.write_page = __block_write_page;
     dev->ops.read = __block_read;
     dev->ops.read_page = __block_read_page;
+    dev->ops.read_page_async = __block_read_page_async;
+    dev->ops.write_pages = __block_write_pages;
+    dev->ops.read_pages = __block_read_pages;
 
     pbdev->start_lba = start_lba;
     pbdev->end_lba = end_lba;
@@ -57,11 +57,25 @@ devfs_write_page(struct v_inode* inode, void* buffer, size_t fpos)
 
     struct device* dev = resolve_device(inode->data);
 
-    if (!dev || !dev->ops.read_page) {
+    if (!dev || !dev->ops.write_page) {
         return ENOTSUP;
     }
 
-    return dev->ops.read_page(dev, buffer, fpos);
+    return dev->ops.write_page(dev, buffer, fpos);
+}
+
+int
+devfs_write_pages(struct v_inode* inode, struct vecbuf* pages, size_t fpos)
+{
+    assert(inode->data);
+
+    struct device* dev = resolve_device(inode->data);
+
+    if (!dev || !dev->ops.write_pages) {
+        return ENOTSUP;
+    }
+
+    return dev->ops.write_pages(dev, pages, fpos);
 }
 
 int
@@ -196,6 +210,7 @@ void
 devfs_init()
 {
     struct filesystem* fs = fsm_new_fs("devfs", 5);
+    fs->types |= FSTYPE_PSEUDO;
     fsm_register(fs);
     fs->mount = devfs_mount;
     fs->unmount = devfs_unmount;
@@ -212,5 +227,6 @@ struct v_file_ops devfs_file_ops = { .close = default_file_close,
                                      .read_page = devfs_read_page,
                                      .write = devfs_write,
                                      .write_page = devfs_write_page,
+                                     .write_pages = devfs_write_pages,
                                      .seek = default_file_seek,
                                      .readdir = devfs_readdir };
\ No newline at end of file
@@ -35,10 +35,13 @@ __do_poll(struct poll_info* pinfo, int pld)
     }
 
     struct device* dev;
+    struct v_file* file = poller->file_ref;
     int evt = 0;
 
-    if ((dev = resolve_device(poller->file_ref->inode->data))) {
-        dev->ops.poll(dev);
+    if ((dev = resolve_device(file->inode->data))) {
+        evt = dev->ops.poll(dev);
+    } else if (file->ops->poll) {
+        evt = file->ops->poll(file, NULL);
     } else {
         // TODO handle generic file
         /*
@@ -156,6 +159,31 @@ __wait_until_event()
     sched_pass();
 }
 
+static void
+__poll_timeout(void* payload)
+{
+    struct thread* thread = (struct thread*)payload;
+
+    if (proc_hanged(thread)) {
+        resume_thread(thread);
+    }
+}
+
+static int
+__arm_timeout(int timeout)
+{
+    // owned by thread, so it is disarmed should we get killed in wait
+    struct lx_timer* timer = &current_thread->sleep.timeout;
+
+    timer_setup(timer, __poll_timeout, current_thread, 0);
+
+    if (timeout < 0) {
+        return 0;
+    }
+
+    return timer_arm(timer, hwtimer_to_ticks(timeout, TIME_MS));
+}
+
 void
 iopoll_init(struct iopoll* ctx)
 {
@@ -207,6 +235,7 @@ iopoll_remove(struct thread* thread, int pld)
 
     // FIXME vfs locking model need to rethink in the presence of threads
     vfs_pclose(poller->file_ref, proc->pid);
+    llist_delete(&poller->evt_listener);
     vfree(poller);
     ctx->pollers[pld] = NULL;
     ctx->n_poller--;
@@ -228,6 +257,7 @@ iopoll_install(struct thread* thread, struct v_fd* fd)
         .thread = thread,
     };
 
+    llist_init_head(&iop->evt_listener);
     vfs_ref_file(fd->file);
 
     struct proc_info* proc = thread->process;
@@ -235,8 +265,12 @@ iopoll_install(struct thread* thread, struct v_fd* fd)
     proc->pollctx.n_poller++;
 
     struct device* dev;
+    poll_evt_q* source;
     if ((dev = fd2dev(fd))) {
         iopoll_listen_on(iop, &dev->pollers);
+    } else if (fd->file->ops->poll) {
+        fd->file->ops->poll(fd->file, &source);
+        iopoll_listen_on(iop, source);
     } else {
         // TODO handle generic file
     }
@@ -247,6 +281,7 @@ iopoll_install(struct thread* thread, struct v_fd* fd)
 __DEFINE_LXSYSCALL2(int, pollctl, int, action, va_list, va)
 {
     int retcode = 0;
+    struct lx_timer* timeout_timer = &current_thread->sleep.timeout;
     switch (action) {
         case _SPOLL_ADD: {
             int* ds = va_arg(va, int*);
@@ -263,24 +298,34 @@ __DEFINE_LXSYSCALL2(int, pollctl, int, action, va_list, va)
             int timeout = va_arg(va, int);
 
             time_t t1 = clock_systime() + timeout;
+            if ((retcode = __arm_timeout(timeout))) {
+                break;
+            }
+
             while (!(retcode == __do_poll_round(pinfos, npinfos))) {
                 if (timeout >= 0 && t1 < clock_systime()) {
                     break;
                 }
                 __wait_until_event();
             }
+            timer_disarm(timeout_timer);
         } break;
         case _SPOLL_WAIT_ANY: {
             struct poll_info* pinfo = va_arg(va, struct poll_info*);
             int timeout = va_arg(va, int);
 
             time_t t1 = clock_systime() + timeout;
+            if ((retcode = __arm_timeout(timeout))) {
+                break;
+            }
+
             while (!(retcode == __do_poll_all(pinfo))) {
                 if (timeout >= 0 && t1 < clock_systime()) {
                     break;
                 }
                 __wait_until_event();
             }
+            timer_disarm(timeout_timer);
         } break;
         default:
             retcode = EINVAL;
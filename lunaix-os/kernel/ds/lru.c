@@ -1,74 +1,263 @@
+#include <lunaix/ds/hashtable.h>
 #include <lunaix/ds/lru.h>
 #include <lunaix/mm/valloc.h>
+#include <lunaix/spike.h>
+
+// which list a node currently lives on
+#define Q_NONE 0
+#define Q_MAIN 1
+#define Q_A1IN 2
+
+#define GHOST_BUCKETS 64
+#define GHOST_MIN 32
+
+struct lru_ghost
+{
+    struct llist_header fifo;
+    struct hlist_node hash;
+    u32_t key;
+};
 
 struct llist_header zone_lead = { .next = &zone_lead, .prev = &zone_lead };
 
-struct lru_zone*
-lru_new_zone(evict_cb try_evict_cb)
+static struct lru_zone*
+__lru_new_zone(const char* name, evict_cb try_evict_cb)
 {
     struct lru_zone* zone = vzalloc(sizeof(struct lru_zone));
     if (!zone) {
         return NULL;
     }
 
+    zone->name = name;
     zone->try_evict = try_evict_cb;
 
     llist_init_head(&zone->lead_node);
+    llist_init_head(&zone->a1in);
+    llist_init_head(&zone->a1out);
     llist_append(&zone_lead, &zone->zones);
 
     return zone;
 }
 
-void
-lru_use_one(struct lru_zone* zone, struct lru_node* node)
+struct lru_zone*
+lru_new_zone(const char* name, evict_cb try_evict_cb)
 {
-    if (node->lru_nodes.next && node->lru_nodes.prev) {
-        llist_delete(&node->lru_nodes);
+    struct lru_zone* zone = __lru_new_zone(name, try_evict_cb);
+    if (zone) {
+        zone->mode = LRU_CLASSIC;
     }
 
-    llist_prepend(&zone->lead_node, &node->lru_nodes);
-    zone->objects++;
+    return zone;
+}
+
+struct lru_zone*
+lru_new_zone_2q(const char* name, evict_cb try_evict_cb, lru_key_cb key_cb)
+{
+    struct lru_zone* zone = __lru_new_zone(name, try_evict_cb);
+    if (!zone) {
+        return NULL;
+    }
+
+    zone->mode = LRU_2Q;
+    zone->key = key_cb;
+    zone->ghosts = vzalloc(GHOST_BUCKETS * sizeof(struct hbucket));
+
+    if (!zone->ghosts) {
+        llist_delete(&zone->zones);
+        vfree(zone);
+        return NULL;
+    }
+
+    return zone;
+}
+
+/*
+    2Q ghost list: keys of objects recently evicted from A1in. Bounded to
+    half of the resident objects.
+*/
+
+static void
+__ghost_drop(struct lru_zone* zone, struct lru_ghost* ghost)
+{
+    llist_delete(&ghost->fifo);
+    hlist_delete(&ghost->hash);
+    vfree(ghost);
+    zone->nr_a1out--;
+}
+
+static void
+__ghost_add(struct lru_zone* zone, u32_t key)
+{
+    struct lru_ghost* ghost;
+    u32_t limit = MAX(zone->objects / 2, GHOST_MIN);
+
+    while (zone->nr_a1out >= limit) {
+        ghost = list_entry(zone->a1out.next, struct lru_ghost, fifo);
+        __ghost_drop(zone, ghost);
+    }
+
+    if (!(ghost = valloc(sizeof(struct lru_ghost)))) {
+        return;
+    }
+
+    *ghost = (struct lru_ghost){ .key = key };
+    llist_append(&zone->a1out, &ghost->fifo);
+    hlist_add(&zone->ghosts[key % GHOST_BUCKETS].head, &ghost->hash);
+    zone->nr_a1out++;
+}
+
+static bool
+__ghost_take(struct lru_zone* zone, u32_t key)
+{
+    struct lru_ghost *pos, *n;
+    struct hbucket* bucket = &zone->ghosts[key % GHOST_BUCKETS];
+
+    hashtable_bucket_foreach(bucket, pos, n, hash)
+    {
+        if (pos->key == key) {
+            __ghost_drop(zone, pos);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+__lru_detach(struct lru_zone* zone, struct lru_node* node)
+{
+    if (node->queue == Q_NONE) {
+        return;
+    }
+
+    if (node->queue == Q_A1IN) {
+        zone->nr_a1in--;
+    }
+
+    llist_delete(&node->lru_nodes);
+    node->queue = Q_NONE;
+    zone->objects--;
 }
 
 static void
-__do_evict(struct lru_zone* zone, struct llist_header* elem)
+__lru_attach(struct lru_zone* zone, struct lru_node* node, u32_t queue)
 {
-    llist_delete(elem);
-    if (!zone->try_evict(container_of(elem, struct lru_node, lru_nodes))) {
-        llist_append(&zone->lead_node, elem);
+    if (queue == Q_A1IN) {
+        llist_prepend(&zone->a1in, &node->lru_nodes);
+        zone->nr_a1in++;
     } else {
-        zone->objects--;
+        llist_prepend(&zone->lead_node, &node->lru_nodes);
     }
+
+    node->queue = queue;
+    zone->objects++;
 }
 
 void
-lru_evict_one(struct lru_zone* zone)
+lru_use_one(struct lru_zone* zone, struct lru_node* node)
 {
-    struct llist_header* tail = zone->lead_node.prev;
-    if (tail == &zone->lead_node) {
+    if (node->queue == Q_A1IN) {
+        // correlated reference, 2Q deliberately ignores it.
+        zone->stats.hits++;
+        return;
+    }
+
+    if (node->queue == Q_MAIN) {
+        zone->stats.hits++;
+        llist_delete(&node->lru_nodes);
+        llist_prepend(&zone->lead_node, &node->lru_nodes);
         return;
     }
 
-    __do_evict(zone, tail);
+    zone->stats.misses++;
+
+    if (zone->mode != LRU_2Q) {
+        __lru_attach(zone, node, Q_MAIN);
+        return;
+    }
+
+    if (zone->key && __ghost_take(zone, zone->key(node))) {
+        zone->stats.ghost_hits++;
+        __lru_attach(zone, node, Q_MAIN);
+        return;
+    }
+
+    __lru_attach(zone, node, Q_A1IN);
+}
+
+static struct lru_node*
+__lru_victim(struct lru_zone* zone)
+{
+    struct llist_header* tail = NULL;
+
+    // keep A1in at about a quarter of the zone
+    if (zone->nr_a1in &&
+        (zone->nr_a1in > zone->objects / 4 || llist_empty(&zone->lead_node))) {
+        tail = zone->a1in.prev;
+    } else if (!llist_empty(&zone->lead_node)) {
+        tail = zone->lead_node.prev;
+    }
+
+    return tail ? container_of(tail, struct lru_node, lru_nodes) : NULL;
+}
+
+static bool
+__do_evict(struct lru_zone* zone, struct lru_node* node)
+{
+    u32_t queue = node->queue;
+    u32_t key = 0;
+
+    // object is gone after a successful try_evict
+    if (queue == Q_A1IN && zone->key) {
+        key = zone->key(node);
+    }
+
+    __lru_detach(zone, node);
+
+    if (!zone->try_evict(node)) {
+        // busy, give it another round.
+        __lru_attach(zone, node, queue);
+        return false;
+    }
+
+    zone->stats.evicted++;
+
+    if (queue == Q_A1IN && zone->key) {
+        __ghost_add(zone, key);
+    }
+
+    return true;
+}
+
+void
+lru_evict_one(struct lru_zone* zone)
+{
+    struct lru_node* victim;
+    u32_t tries = zone->objects;
+
+    while (tries-- && (victim = __lru_victim(zone))) {
+        if (__do_evict(zone, victim)) {
+            return;
+        }
+    }
 }
 
 void
 lru_evict_half(struct lru_zone* zone)
 {
-    int target = (int)(zone->objects / 2);
-    struct llist_header* tail = zone->lead_node.prev;
-    while (tail != &zone->lead_node && target > 0) {
-        __do_evict(zone, tail);
-        tail = tail->prev;
-        target--;
+    struct lru_node* victim;
+    u32_t target = zone->objects / 2;
+    u32_t tries = zone->objects;
+
+    while (target && tries-- && (victim = __lru_victim(zone))) {
+        if (__do_evict(zone, victim)) {
+            target--;
+        }
     }
 }
 
 void
 lru_remove(struct lru_zone* zone, struct lru_node* node)
 {
-    if (node->lru_nodes.next && node->lru_nodes.prev) {
-        llist_delete(&node->lru_nodes);
-    }
-    zone->objects--;
-}
\ No newline at end of file
+    __lru_detach(zone, node);
+}
@@ -0,0 +1,56 @@
+#include <lunaix/ds/lru.h>
+#include <lunaix/fs/twifs.h>
+
+extern struct llist_header zone_lead;
+
+static int
+__lru_stat_gonext(struct twimap* map)
+{
+    struct lru_zone* zone = twimap_index(map, struct lru_zone*);
+    if (zone->zones.next == &zone_lead) {
+        return 0;
+    }
+    map->index = list_entry(zone->zones.next, struct lru_zone, zones);
+    return 1;
+}
+
+static void
+__lru_stat_reset(struct twimap* map)
+{
+    map->index = container_of(zone_lead.next, struct lru_zone, zones);
+}
+
+/*
+    name mode objects a1in a1out hits misses ghost_hits evicted
+*/
+static void
+__lru_rd_stat(struct twimap* map)
+{
+    struct lru_zone* zone = twimap_index(map, struct lru_zone*);
+    if (&zone->zones == &zone_lead) {
+        return;
+    }
+
+    twimap_printf(map,
+                  "%s %s %u %u %u %u %u %u %u\n",
+                  zone->name,
+                  zone->mode == LRU_2Q ? "2q" : "lru",
+                  zone->objects,
+                  zone->nr_a1in,
+                  zone->nr_a1out,
+                  zone->stats.hits,
+                  zone->stats.misses,
+                  zone->stats.ghost_hits,
+                  zone->stats.evicted);
+}
+
+void
+lru_export()
+{
+    struct twimap* map = twifs_mapping(NULL, NULL, "lru_zones");
+    map->reset = __lru_stat_reset;
+    map->go_next = __lru_stat_gonext;
+    map->read = __lru_rd_stat;
+    __lru_stat_reset(map);
+}
+EXPORT_TWIFS_PLUGIN(lru_zones, lru_export);
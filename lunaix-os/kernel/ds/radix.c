@@ -0,0 +1,373 @@
+/**
+ * @file radix.c
+ * @brief Radix tree with direct indexed child arrays for sparse array.
+ *
+ */
+
+#include <lunaix/ds/radix.h>
+#include <lunaix/mm/cake.h>
+#include <lunaix/spike.h>
+#include <lunaix/status.h>
+
+#include <klibc/string.h>
+
+#define SLOT_BIT(off) (1U << (off))
+
+static struct cake_pile* radix_pile;
+
+static inline u32_t
+__top_shift(struct radix_tree* tree)
+{
+    return (tree->height - 1) * RADIX_BITS;
+}
+
+static inline bool
+__fits(struct radix_tree* tree, u32_t index)
+{
+    u32_t bits = tree->height * RADIX_BITS;
+    return bits >= 32 || !(index >> bits);
+}
+
+static struct radix_node*
+__radix_new_node(struct radix_node* parent, u32_t offset)
+{
+    struct radix_node* node = cake_grab(radix_pile);
+    if (!node) {
+        return NULL;
+    }
+
+    memset(node, 0, sizeof(*node));
+    node->parent = parent;
+    node->offset = offset;
+
+    return node;
+}
+
+static int
+__radix_grow(struct radix_tree* tree, u32_t index)
+{
+    struct radix_node *root = tree->root, *new_root;
+
+    if (!root) {
+        tree->height = 1;
+        while (!__fits(tree, index)) {
+            tree->height++;
+        }
+
+        tree->root = __radix_new_node(NULL, 0);
+        if (!tree->root) {
+            tree->height = 0;
+            return ENOMEM;
+        }
+
+        return 0;
+    }
+
+    while (!__fits(tree, index)) {
+        if (!(new_root = __radix_new_node(NULL, 0))) {
+            return ENOMEM;
+        }
+
+        new_root->slots[0] = root;
+        new_root->present = SLOT_BIT(0);
+        new_root->count = 1;
+
+        for (int i = 0; i < RADIX_MAX_TAGS; i++) {
+            if (root->tags[i]) {
+                new_root->tags[i] = SLOT_BIT(0);
+            }
+        }
+
+        root->parent = new_root;
+        root = new_root;
+
+        tree->root = root;
+        tree->height++;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Locate the leaf node that covers `index`.
+ */
+static struct radix_node*
+__radix_leaf(struct radix_tree* tree, u32_t index)
+{
+    struct radix_node* node = tree->root;
+    u32_t shift, off;
+
+    if (!node || !__fits(tree, index)) {
+        return NULL;
+    }
+
+    for (shift = __top_shift(tree); shift && node; shift -= RADIX_BITS) {
+        off = (index >> shift) & RADIX_MASK;
+        node = node->slots[off];
+    }
+
+    return node;
+}
+
+void
+radix_init(struct radix_tree* tree)
+{
+    if (!radix_pile) {
+        radix_pile =
+          cake_new_pile("radix_node", sizeof(struct radix_node), 1, 0);
+    }
+
+    tree->root = NULL;
+    tree->height = 0;
+}
+
+void*
+radix_get(struct radix_tree* tree, u32_t index)
+{
+    struct radix_node* leaf = __radix_leaf(tree, index);
+    if (!leaf) {
+        return NULL;
+    }
+
+    return leaf->slots[index & RADIX_MASK];
+}
+
+int
+radix_set(struct radix_tree* tree, u32_t index, void* item)
+{
+    struct radix_node *node, *child;
+    u32_t shift, off;
+    int errno;
+
+    if ((errno = __radix_grow(tree, index))) {
+        return errno;
+    }
+
+    node = tree->root;
+    for (shift = __top_shift(tree); shift; shift -= RADIX_BITS) {
+        off = (index >> shift) & RADIX_MASK;
+        child = node->slots[off];
+
+        if (!child) {
+            if (!(child = __radix_new_node(node, off))) {
+                return ENOMEM;
+            }
+
+            node->slots[off] = child;
+            node->present |= SLOT_BIT(off);
+            node->count++;
+        }
+
+        node = child;
+    }
+
+    off = index & RADIX_MASK;
+    if (!(node->present & SLOT_BIT(off))) {
+        node->present |= SLOT_BIT(off);
+        node->count++;
+    }
+
+    node->slots[off] = item;
+    return 0;
+}
+
+static void
+__radix_untag(struct radix_node* node, u32_t off, int tag)
+{
+    while (node) {
+        node->tags[tag] &= ~SLOT_BIT(off);
+        if (node->tags[tag]) {
+            break;
+        }
+
+        off = node->offset;
+        node = node->parent;
+    }
+}
+
+void*
+radix_remove(struct radix_tree* tree, u32_t index)
+{
+    struct radix_node *node = __radix_leaf(tree, index), *parent;
+    u32_t off = index & RADIX_MASK;
+    void* item;
+
+    if (!node || !(node->present & SLOT_BIT(off))) {
+        return NULL;
+    }
+
+    item = node->slots[off];
+
+    for (int i = 0; i < RADIX_MAX_TAGS; i++) {
+        if ((node->tags[i] & SLOT_BIT(off))) {
+            __radix_untag(node, off, i);
+        }
+    }
+
+    node->slots[off] = NULL;
+    node->present &= ~SLOT_BIT(off);
+    node->count--;
+
+    // collapse the emptied path
+    while (!node->count) {
+        parent = node->parent;
+        off = node->offset;
+
+        cake_release(radix_pile, node);
+
+        if (!parent) {
+            tree->root = NULL;
+            tree->height = 0;
+            break;
+        }
+
+        parent->slots[off] = NULL;
+        parent->present &= ~SLOT_BIT(off);
+        parent->count--;
+        node = parent;
+    }
+
+    return item;
+}
+
+static size_t
+__radix_gang(struct radix_node* node,
+             u32_t shift,
+             u32_t base,
+             u32_t start,
+             void** items,
+             size_t max,
+             int tag)
+{
+    u32_t mask = tag < 0 ? node->present : node->tags[tag];
+    u32_t first = 0, off;
+    size_t n = 0;
+
+    if (start > base) {
+        first = (start - base) >> shift;
+        if (first >= RADIX_SLOTS) {
+            return 0;
+        }
+
+        mask &= ~(SLOT_BIT(first) - 1);
+    }
+
+    while (mask && n < max) {
+        off = ctz(mask);
+        mask &= mask - 1;
+
+        if (!shift) {
+            items[n++] = node->slots[off];
+            continue;
+        }
+
+        n += __radix_gang(node->slots[off],
+                          shift - RADIX_BITS,
+                          base + (off << shift),
+                          start,
+                          &items[n],
+                          max - n,
+                          tag);
+    }
+
+    return n;
+}
+
+size_t
+radix_gang_lookup(struct radix_tree* tree,
+                  void** items,
+                  u32_t start,
+                  size_t max)
+{
+    if (!tree->root || !__fits(tree, start)) {
+        return 0;
+    }
+
+    return __radix_gang(tree->root, __top_shift(tree), 0, start, items, max, -1);
+}
+
+size_t
+radix_gang_lookup_tag(struct radix_tree* tree,
+                      void** items,
+                      u32_t start,
+                      size_t max,
+                      int tag)
+{
+    assert(tag >= 0 && tag < RADIX_MAX_TAGS);
+
+    if (!tree->root || !__fits(tree, start)) {
+        return 0;
+    }
+
+    return __radix_gang(
+      tree->root, __top_shift(tree), 0, start, items, max, tag);
+}
+
+void
+radix_tag_set(struct radix_tree* tree, u32_t index, int tag)
+{
+    struct radix_node* node = __radix_leaf(tree, index);
+    u32_t off = index & RADIX_MASK;
+
+    assert(tag >= 0 && tag < RADIX_MAX_TAGS);
+
+    if (!node || !(node->present & SLOT_BIT(off))) {
+        return;
+    }
+
+    while (node && !(node->tags[tag] & SLOT_BIT(off))) {
+        node->tags[tag] |= SLOT_BIT(off);
+        off = node->offset;
+        node = node->parent;
+    }
+}
+
+void
+radix_tag_clear(struct radix_tree* tree, u32_t index, int tag)
+{
+    struct radix_node* node = __radix_leaf(tree, index);
+    u32_t off = index & RADIX_MASK;
+
+    assert(tag >= 0 && tag < RADIX_MAX_TAGS);
+
+    if (!node || !(node->tags[tag] & SLOT_BIT(off))) {
+        return;
+    }
+
+    __radix_untag(node, off, tag);
+}
+
+bool
+radix_tag_get(struct radix_tree* tree, u32_t index, int tag)
+{
+    struct radix_node* node = __radix_leaf(tree, index);
+
+    return node && (node->tags[tag] & SLOT_BIT(index & RADIX_MASK));
+}
+
+static void
+__radix_release(struct radix_node* node, u32_t shift)
+{
+    u32_t mask = node->present, off;
+
+    if (shift) {
+        while (mask) {
+            off = ctz(mask);
+            mask &= mask - 1;
+            __radix_release(node->slots[off], shift - RADIX_BITS);
+        }
+    }
+
+    cake_release(radix_pile, node);
+}
+
+void
+radix_release(struct radix_tree* tree)
+{
+    if (tree->root) {
+        __radix_release(tree->root, __top_shift(tree));
+    }
+
+    tree->root = NULL;
+    tree->height = 0;
+}
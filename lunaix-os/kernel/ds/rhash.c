@@ -0,0 +1,199 @@
+#include <lunaix/ds/rhash.h>
+#include <lunaix/mm/page.h>
+#include <lunaix/mm/valloc.h>
+#include <lunaix/spike.h>
+
+#include <klibc/string.h>
+
+// average chain length to grow at
+#define RHASH_GROW_LOAD 2U
+// ... and to shrink below, in 1/8
+#define RHASH_SHRINK_LOAD 1U
+
+static inline u32_t
+__rhash_index(u32_t key, u32_t order)
+{
+    return order ? hash_32(key, order) : 0;
+}
+
+static struct hbucket*
+__rhash_alloc(u32_t order)
+{
+    struct leaflet* leaflet;
+    struct hbucket* buckets;
+    size_t size = sizeof(struct hbucket) << order;
+
+    if (size < PAGE_SIZE) {
+        return vzalloc(size);
+    }
+
+    // too large for valloc
+    if (!(leaflet = alloc_leaflet(ILOG2(size / PAGE_SIZE)))) {
+        return NULL;
+    }
+
+    if (!(buckets = (struct hbucket*)vmap(leaflet, KERNEL_DATA))) {
+        leaflet_return(leaflet);
+        return NULL;
+    }
+
+    memset(buckets, 0, size);
+    return buckets;
+}
+
+static void
+__rhash_free(struct hbucket* buckets, u32_t order)
+{
+    struct leaflet* leaflet;
+    size_t size = sizeof(struct hbucket) << order;
+
+    if (size < PAGE_SIZE) {
+        vfree(buckets);
+        return;
+    }
+
+    leaflet = pte_leaflet(pte_at(mkptep_va(VMS_SELF, (ptr_t)buckets)));
+    vunmap((ptr_t)buckets, leaflet);
+    leaflet_return(leaflet);
+}
+
+static void
+__rhash_resize(struct rhash_table* table, u32_t order)
+{
+    struct hbucket* buckets;
+
+    if (table->moving || !(buckets = __rhash_alloc(order))) {
+        return;
+    }
+
+    table->moving = table->buckets;
+    table->moving_order = table->order;
+    table->moved = 0;
+
+    table->buckets = buckets;
+    table->order = order;
+}
+
+static void
+__rhash_step(struct rhash_table* table)
+{
+    struct hbucket *old, *new;
+    struct hlist_node* node;
+    u32_t nr_old, i;
+
+    if (!table->moving) {
+        return;
+    }
+
+    nr_old = 1U << table->moving_order;
+    for (i = 0; i < RHASH_STEP && table->moved < nr_old; i++) {
+        old = &table->moving[table->moved++];
+
+        while ((node = old->head)) {
+            hlist_delete(node);
+
+            new = &table->buckets[__rhash_index(table->key(node), table->order)];
+            hlist_add(&new->head, node);
+        }
+    }
+
+    if (table->moved == nr_old) {
+        __rhash_free(table->moving, table->moving_order);
+        table->moving = NULL;
+    }
+}
+
+static inline struct hbucket*
+__rhash_locate(struct rhash_table* table, u32_t key)
+{
+    u32_t i;
+
+    if (table->moving) {
+        i = __rhash_index(key, table->moving_order);
+        if (i >= table->moved) {
+            return &table->moving[i];
+        }
+    }
+
+    return &table->buckets[__rhash_index(key, table->order)];
+}
+
+void
+rhash_init(struct rhash_table* table, u32_t min_order, rhash_key_cb key)
+{
+    assert(min_order <= RHASH_MAX_ORDER);
+
+    *table = (struct rhash_table){ .order = min_order,
+                                   .min_order = min_order,
+                                   .key = key };
+
+    table->buckets = __rhash_alloc(min_order);
+    assert(table->buckets);
+}
+
+struct hbucket*
+rhash_bucket(struct rhash_table* table, u32_t key)
+{
+    __rhash_step(table);
+
+    return __rhash_locate(table, key);
+}
+
+void
+rhash_add(struct rhash_table* table, struct hlist_node* node, u32_t key)
+{
+    __rhash_step(table);
+
+    table->entries++;
+    if (table->order < RHASH_MAX_ORDER &&
+        table->entries > (RHASH_GROW_LOAD << table->order)) {
+        __rhash_resize(table, table->order + 1);
+    }
+
+    hlist_add(&__rhash_locate(table, key)->head, node);
+}
+
+void
+rhash_remove(struct rhash_table* table, struct hlist_node* node)
+{
+    if (!node->pprev) {
+        return;
+    }
+
+    hlist_delete(node);
+
+    // no moving here, someone might be walking the bucket
+    table->entries--;
+    if (table->order > table->min_order &&
+        table->entries * 8 < (RHASH_SHRINK_LOAD << table->order)) {
+        __rhash_resize(table, table->order - 1);
+    }
+}
+
+static void
+__rhash_detach_all(struct hbucket* buckets, u32_t order)
+{
+    struct hlist_node* node;
+
+    for (u32_t i = 0; i < (1U << order); i++) {
+        while ((node = buckets[i].head)) {
+            hlist_delete(node);
+        }
+    }
+}
+
+void
+rhash_release(struct rhash_table* table)
+{
+    if (table->moving) {
+        __rhash_detach_all(table->moving, table->moving_order);
+        __rhash_free(table->moving, table->moving_order);
+    }
+
+    __rhash_detach_all(table->buckets, table->order);
+    __rhash_free(table->buckets, table->order);
+
+    table->buckets = NULL;
+    table->moving = NULL;
+    table->entries = 0;
+}
@@ -34,7 +34,7 @@ pwake_one(waitq_t* queue)
     struct thread* thread = container_of(wq, struct thread, waitqueue);
 
     assert(thread->state == PS_BLOCKED);
-    thread->state = PS_READY;
+    resume_thread(thread);
     llist_delete(&wq->waiters);
 }
 
@@ -52,7 +52,7 @@ pwake_all(waitq_t* queue)
         thread = container_of(pos, struct thread, waitqueue);
 
         assert(thread->state == PS_BLOCKED);
-        thread->state = PS_READY;
+        resume_thread(thread);
         llist_delete(&pos->waiters);
     }
 }
\ No newline at end of file
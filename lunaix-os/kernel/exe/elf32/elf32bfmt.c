@@ -9,7 +9,7 @@ static inline int
 elf32_read(struct v_file* elf, void* data, size_t off, size_t len)
 {
     // it is wise to do cached read
-    return pcache_read(elf->inode, data, len, off);
+    return pcache_read(elf->inode, NULL, data, len, off);
 }
 
 static int
@@ -10,6 +10,7 @@
 #include <lunaix/status.h>
 #include <lunaix/syscall.h>
 #include <lunaix/syscall_utils.h>
+#include <lunaix/vdso.h>
 
 #include <sys/abi.h>
 #include <sys/mm/mm_defs.h>
@@ -123,6 +124,8 @@ exec_load(struct exec_container* container, struct v_file* executable)
         create_heap(vmspace(proc), page_aligned(container->exe.end));
     }
 
+    ptr_t vdso = vdso_map(pvms, container->vms_mnt);
+
     if (container->vms_mnt == VMS_SELF) {
         // we are loading executable into current addr space
 
@@ -172,7 +175,8 @@ exec_load(struct exec_container* container, struct v_file* executable)
           (struct uexec_param){ .argc = (argv_len - 1) / sizeof(ptr_t),
                                 .argv = (char**)argv_ptr,
                                 .envc = (envp_len - 1) / sizeof(ptr_t),
-                                .envp = (char**)envp_ptr };
+                                .envp = (char**)envp_ptr,
+                                .vdso = (void*)vdso };
     } else {
         /*
             TODO Inject to remote user stack with our procvm_remote toolsets
@@ -235,6 +239,7 @@ exec_kexecve(const char* filename, const char* argv[], const char* envp[])
     ptr_t entry = container.exe.entry;
 
     assert(entry);
+    vdso_update(current_thread);
     j_usr(container.stack_top, entry);
 
     // should not reach
@@ -42,22 +42,57 @@ default_file_write_page(struct v_inode* inode, void* buffer, size_t fpos)
     return ENOTSUP;
 }
 
+static struct llist_header*
+__dir_next(struct llist_header* head, struct llist_header* pos)
+{
+    struct v_dnode* dnode;
+
+    while ((pos = pos->next) != head) {
+        dnode = container_of(pos, struct v_dnode, siblings);
+        if (!vfs_d_negative(dnode)) {
+            return pos;
+        }
+    }
+
+    return NULL;
+}
+
 int
 default_file_readdir(struct v_file* file, struct dir_context* dctx)
 {
-    int i = 0;
-    struct v_dnode *pos, *n;
-    llist_for_each(pos, n, &file->dnode->children, siblings)
-    {
-        if (i < dctx->index) {
-            i++;
-            continue;
+    struct dir_cursor* cursor = &file->dcursor;
+    struct llist_header* head = &file->dnode->children;
+    struct llist_header* pos = head;
+    struct v_dnode* dnode;
+
+    if (!cursor->pos || cursor->index != (u32_t)dctx->index) {
+        // rewound or seeked, count from the start
+        for (int i = 0; pos && i < dctx->index; i++) {
+            pos = __dir_next(head, pos);
         }
-        dctx->read_complete_callback(dctx, pos->name.value, pos->name.len, 0);
-        break;
+
+        if (!pos) {
+            return 0;
+        }
+
+        cursor->pos = pos;
+        vfs_dcursor_track(cursor, &file->dnode->cursors);
     }
 
-    return i;
+    if (!(pos = __dir_next(head, cursor->pos))) {
+        return 0;
+    }
+
+    dnode = container_of(pos, struct v_dnode, siblings);
+    dctx->read_complete_callback(dctx,
+                                 dnode->name.value,
+                                 dnode->name.len,
+                                 vfs_get_dtype(dnode->inode->itype));
+
+    cursor->pos = pos;
+    cursor->index = dctx->index + 1;
+
+    return 1;
 }
 
 int
@@ -1,5 +1,7 @@
+#include <lunaix/buffer.h>
 #include <lunaix/fs.h>
 #include <lunaix/fs/iso9660.h>
+#include <lunaix/mm/page.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/spike.h>
 
@@ -20,14 +22,125 @@ iso9660_close(struct v_file* file)
     return 0;
 }
 
+/**
+ * @brief Find where file block `blk` sits on disk.
+ *
+ * @return u32_t number of blocks laid out contiguously from there on, 0 if
+ * that is up to the end of file.
+ */
+static u32_t
+__iso9660_locate(struct v_inode* inode, u32_t blk, u32_t* lba)
+{
+    struct iso_inode* isoino = inode->data;
+    u32_t fu = blk / isoino->fu_size, sec = blk % isoino->fu_size;
+
+    // how many blocks (file unit + gaps) before of our current read position
+    *lba = inode->lb_addr + fu * (isoino->fu_size + isoino->gap_size) + sec;
+
+    // interleaved, only the rest of file unit is contiguous
+    return isoino->gap_size ? isoino->fu_size - sec : 0;
+}
+
+static int
+__iso9660_read_vec(struct device* bdev, struct vecbuf* vbuf, u32_t lba)
+{
+    struct vecbuf* pos = vbuf;
+    size_t offset = lba * ISO9660_BLKSZ;
+    int errno;
+
+    if (bdev->ops.read_pages) {
+        return bdev->ops.read_pages(bdev, vbuf, offset);
+    }
+
+    do {
+        errno = bdev->ops.read(bdev, pos->buf.buffer, offset, pos->buf.size);
+        if (errno < 0) {
+            return errno;
+        }
+
+        offset += pos->buf.size;
+        pos = list_entry(pos->components.next, struct vecbuf, components);
+    } while (pos != vbuf);
+
+    return 0;
+}
+
+/**
+ * @brief Read at most `len` bytes of a contiguous run starting `skip` bytes
+ * into block `lba`. Whole blocks are read straight into `buffer`, only the
+ * partial ones at either end go through a bounce buffer.
+ *
+ * @return int bytes read, or error
+ */
+static int
+__iso9660_read_run(struct device* bdev,
+                   u32_t lba,
+                   u32_t skip,
+                   void* buffer,
+                   size_t len)
+{
+    struct vecbuf* vbuf = NULL;
+    void *head = NULL, *tail = NULL, *dst;
+    size_t head_len = skip ? MIN(len, ISO9660_BLKSZ - skip) : 0;
+    size_t mid_len, tail_len, chunk;
+    int errno;
+
+    if (((ptr_t)buffer + head_len) % ISO9660_BLKSZ) {
+        // device can not land blocks there, one at a time then.
+        head_len = MIN(len, ISO9660_BLKSZ - skip);
+        len = head_len;
+    }
+
+    mid_len = ROUNDDOWN(len - head_len, ISO9660_BLKSZ);
+    tail_len = len - head_len - mid_len;
+
+    if (head_len) {
+        head = valloc(ISO9660_BLKSZ);
+        vbuf_alloc(&vbuf, head, ISO9660_BLKSZ);
+    }
+
+    // one component per page, as the pages might not be physically adjacent
+    for (dst = buffer + head_len; dst < buffer + head_len + mid_len;
+         dst += chunk) {
+        chunk = MIN(PAGE_SIZE - ((ptr_t)dst % PAGE_SIZE),
+                    (size_t)(buffer + head_len + mid_len - dst));
+        vbuf_alloc(&vbuf, dst, chunk);
+    }
+
+    if (tail_len) {
+        tail = valloc(ISO9660_BLKSZ);
+        vbuf_alloc(&vbuf, tail, ISO9660_BLKSZ);
+    }
+
+    if ((errno = __iso9660_read_vec(bdev, vbuf, lba)) >= 0) {
+        memcpy(buffer, head + skip, head_len);
+        memcpy(buffer + head_len + mid_len, tail, tail_len);
+        errno = len;
+    }
+
+    vbuf_free(vbuf);
+
+    if (head) {
+        vfree(head);
+    }
+
+    if (tail) {
+        vfree(tail);
+    }
+
+    return errno;
+}
+
 int
 iso9660_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
 {
     // This read implementation handle both interleaved and non-interleaved
     // structuring
 
-    struct iso_inode* isoino = inode->data;
     struct device* bdev = inode->sb->dev;
+    size_t i = 0, rd_len;
+    u32_t lba, run;
+    int errno;
 
     len = MIN(fpos + len, inode->fsize);
     if (len <= fpos) {
@@ -36,48 +149,26 @@ iso9660_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
 
     len -= fpos;
 
-    size_t fu_len = isoino->fu_size * ISO9660_BLKSZ;
-    // if fpos is not FU aligned, then we must do an extra read.
-    size_t fu_to_read =
-      ICEIL(len, fu_len) + (fpos > fu_len && (fpos % fu_len) != 0);
-    size_t sec = (fpos % fu_len) / ISO9660_BLKSZ;
-    size_t wd_start = fpos % ISO9660_BLKSZ,
-           wd_len = MIN(len, ISO9660_BLKSZ - wd_start), i = 0;
-
-    // how many blocks (file unit + gaps) before of our current read position
-    size_t true_offset = (fpos / fu_len);
-    true_offset = true_offset * (isoino->fu_size + isoino->gap_size);
-
-    void* rd_buffer = valloc(ISO9660_BLKSZ);
+    while (i < len) {
+        run = __iso9660_locate(inode, fpos / ISO9660_BLKSZ, &lba);
 
-    true_offset += sec + inode->lb_addr;
-
-    int errno = 0;
-    while (fu_to_read) {
-        for (; sec < isoino->fu_size && i < len; sec++) {
-            errno = bdev->ops.read(
-              bdev, rd_buffer, true_offset * ISO9660_BLKSZ, ISO9660_BLKSZ);
-
-            if (errno < 0) {
-                errno = EIO;
-                goto done;
-            }
+        rd_len = len - i;
+        if (run) {
+            rd_len = MIN(rd_len, run * ISO9660_BLKSZ - fpos % ISO9660_BLKSZ);
+        }
 
-            memcpy(buffer + i, rd_buffer + wd_start, wd_len);
+        errno = __iso9660_read_run(
+          bdev, lba, fpos % ISO9660_BLKSZ, buffer + i, rd_len);
 
-            i += wd_len;
-            true_offset++;
-            wd_start = 0;
-            wd_len = MIN(len - i, ISO9660_BLKSZ);
+        if (errno < 0) {
+            return EIO;
         }
-        sec = 0;
-        fu_to_read--;
+
+        i += errno;
+        fpos += errno;
     }
-    errno = i;
 
-done:
-    vfree(rd_buffer);
-    return errno;
+    return i;
 }
 
 int
@@ -86,6 +177,30 @@ iso9660_read_page(struct v_inode* inode, void* buffer, size_t fpos)
     return iso9660_read(inode, buffer, MEM_PAGE, fpos);
 }
 
+int
+iso9660_read_page_async(struct v_inode* inode,
+                        void* buffer,
+                        size_t fpos,
+                        devio_done_cb done,
+                        void* arg)
+{
+    struct iso_inode* isoino = inode->data;
+    struct device* bdev = inode->sb->dev;
+
+    // only the file that laid out contiguously can be mapped to a single
+    //  device read.
+    if (isoino->gap_size || !bdev->ops.read_page_async) {
+        return ENOTSUP;
+    }
+
+    if (fpos >= inode->fsize) {
+        return 0;
+    }
+
+    return bdev->ops.read_page_async(
+      bdev, buffer, inode->lb_addr * ISO9660_BLKSZ + fpos, done, arg);
+}
+
 int
 iso9660_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
 {
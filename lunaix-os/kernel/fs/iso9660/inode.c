@@ -15,6 +15,8 @@ static struct v_inode_ops iso_inode_ops = {
 static struct v_file_ops iso_file_ops = { .close = iso9660_close,
                                           .read = iso9660_read,
                                           .read_page = iso9660_read_page,
+                                          .read_page_async =
+                                            iso9660_read_page_async,
                                           .write = iso9660_write,
                                           .write_page = iso9660_write_page,
                                           .seek = iso9660_seek,
@@ -52,15 +52,6 @@ __vfs_do_unmount(struct v_mount* mnt)
     llist_delete(&mnt->list);
     llist_delete(&mnt->sibmnts);
 
-    // detached the inodes from cache, and let lru policy to recycle them
-    for (size_t i = 0; i < VFS_HASHTABLE_SIZE; i++) {
-        struct hbucket* bucket = &sb->i_cache[i];
-        if (!bucket) {
-            continue;
-        }
-        bucket->head->pprev = 0;
-    }
-
     mnt_chillax(mnt->parent);
 
     mnt->mnt_point->mnt = mnt->parent;
@@ -148,7 +139,7 @@ vfs_mount_at(const char* fs_name,
         return ENODEV;
     }
 
-    if (fs->types == FSTYPE_ROFS) {
+    if ((fs->types & FSTYPE_ROFS)) {
         options |= MNT_RO;
     }
 
@@ -174,6 +165,9 @@ vfs_mount_at(const char* fs_name,
 
         kprintf("mount: dev=%s, fs=%s, mode=%d", dev_name, fs_name, options);
 
+        // whatever absent before does not mean the same for new fs
+        vfs_dcache_prune_negative(mnt_point);
+
         mnt_point->mnt->flags = options;
     } else {
         goto cleanup;
@@ -211,6 +205,7 @@ vfs_unmount_at(struct v_dnode* mnt_point)
 
     if (!(errno = __vfs_do_unmount(mnt_point->mnt))) {
         atomic_fetch_sub(&mnt_point->ref_count, 1);
+        vfs_dcache_prune_negative(mnt_point);
     }
 
     return errno;
@@ -9,6 +9,13 @@
 
 extern struct lru_zone *dnode_lru, *inode_lru;
 
+static inline bool
+__vfs_cache_negative(struct v_dnode* dir, struct v_dnode* dnode)
+{
+    return vfs_d_negative(dnode) &&
+           !(dir->super_block->fs->types & FSTYPE_PSEUDO);
+}
+
 int
 __vfs_walk(struct v_dnode* start,
            const char* path,
@@ -84,6 +91,19 @@ __vfs_walk(struct v_dnode* start,
 
         dnode = vfs_dcache_lookup(current_level, &name);
 
+        if (dnode && vfs_d_negative(dnode)) {
+            if (!(walk_options & VFS_WALK_MKPARENT)) {
+                // known to be absent, spare the filesystem
+                lru_use_one(dnode_lru, &dnode->lru);
+                unlock_dnode(current_level);
+                errno = ENOENT;
+                goto error;
+            }
+
+            // to be replaced upon vfs_dcache_add
+            dnode = NULL;
+        }
+
         if (!dnode) {
             dnode = vfs_d_alloc(current_level, &name);
 
@@ -107,6 +127,12 @@ __vfs_walk(struct v_dnode* start,
             vfs_dcache_add(current_level, dnode);
             unlock_inode(current_inode);
 
+            if (errno == ENOENT && __vfs_cache_negative(current_level, dnode)) {
+                // keep it to answer the same lookup next time
+                unlock_dnode(current_level);
+                goto error;
+            }
+
             if (errno) {
                 unlock_dnode(current_level);
                 goto cleanup;
@@ -1,18 +1,117 @@
 #include <klibc/string.h>
-#include <lunaix/ds/btrie.h>
+#include <lunaix/blkio.h>
+#include <lunaix/buffer.h>
+#include <lunaix/ds/radix.h>
 #include <lunaix/fs.h>
+#include <lunaix/kpreempt.h>
 #include <lunaix/mm/page.h>
 #include <lunaix/mm/valloc.h>
+#include <lunaix/process.h>
+#include <lunaix/sched.h>
 #include <lunaix/spike.h>
 
+#include <sys/cpu.h>
+
 #define PCACHE_DIRTY 0x1
+// being filled asynchronously
+#define PCACHE_INFLIGHT 0x2
+// async fill failed, content is garbage
+#define PCACHE_STALE 0x4
+// being written back
+#define PCACHE_WRITEBACK 0x8
+
+// readahead window bounds, in pages
+#define PCACHE_RA_MIN 4
+#define PCACHE_RA_MAX 32
+
+// writeback: period and age of dirty pages to be flushed, in ms
+#define PCACHE_WB_INTERVAL 1000
+#define PCACHE_WB_EXPIRE 3000
+// writeback: flush everything once dirty pages exceed this percentage
+#define PCACHE_WB_RATIO 20
+#define PCACHE_WB_MIN_DIRTY 16
+// writeback: maximum pages in a single write
+#define PCACHE_WB_BATCH 32
+
+// radix tree tags
+#define PCACHE_TAG_DIRTY 0
+#define PCACHE_TAG_WRITEBACK 1
+
+#define pg_index(fpos) ((fpos) >> PAGE_SHIFT)
 
 static struct lru_zone* pcache_zone;
 
+// all page caches that hold dirty pages, for writeback
+static DEFINE_LLIST(dirty_caches);
+static u32_t nr_cached, nr_dirty;
+
+static struct thread* wb_thread;
+static bool wb_dozing;
+
+static inline bool
+__pcache_too_dirty()
+{
+    return nr_dirty >= PCACHE_WB_MIN_DIRTY &&
+           nr_dirty * 100 > nr_cached * PCACHE_WB_RATIO;
+}
+
+static void
+__pcache_kick_writeback()
+{
+    if (wb_thread && wb_dozing) {
+        wb_dozing = false;
+        resume_thread(wb_thread);
+    }
+}
+
+static void
+__pcache_clear_dirty(struct pcache* pcache, struct pcache_pg* pg)
+{
+    pg->flags &= ~PCACHE_DIRTY;
+    llist_delete(&pg->dirty_list);
+    radix_tag_clear(&pcache->tree, pg_index(pg->fpos), PCACHE_TAG_DIRTY);
+    nr_dirty--;
+
+    if (!--pcache->n_dirty) {
+        llist_delete(&pcache->wb_list);
+    }
+}
+
+static inline struct leaflet*
+__pcache_leaflet(void* va)
+{
+    pte_t* ptep = mkptep_va(VMS_SELF, (ptr_t)va);
+    return pte_leaflet(pte_at(ptep));
+}
+
+static u32_t
+__pcache_key(struct lru_node* obj)
+{
+    struct pcache_pg* page = container_of(obj, struct pcache_pg, lru);
+
+    return (u32_t)page->holder * 31 + (page->fpos >> PAGE_SHIFT);
+}
+
 static int
 __pcache_try_evict(struct lru_node* obj)
 {
     struct pcache_pg* page = container_of(obj, struct pcache_pg, lru);
+    if ((page->flags & (PCACHE_INFLIGHT | PCACHE_WRITEBACK))) {
+        return 0;
+    }
+
+    if (leaflet_refcount(__pcache_leaflet(page->pg)) > 1) {
+        // still mapped by someone
+        return 0;
+    }
+
+    if ((page->flags & PCACHE_DIRTY)) {
+        // never write on behalf of whoever is allocating, let writeback
+        //  thread clean it up.
+        __pcache_kick_writeback();
+        return 0;
+    }
+
     pcache_invalidate(page->holder, page);
     return 1;
 }
@@ -20,9 +119,7 @@ __pcache_try_evict(struct lru_node* obj)
 static void
 pcache_free_page(void* va)
 {
-    pte_t* ptep = mkptep_va(VMS_SELF, (ptr_t)va);
-    pte_t pte = pte_at(ptep);
-    leaflet_return(pte_leaflet(pte));
+    leaflet_return(__pcache_leaflet(va));
 }
 
 static void*
@@ -44,14 +141,61 @@ pcache_alloc_page()
     return (void*)va;
 }
 
+static inline void
+__pcache_zero_tail(struct pcache_pg* pg, u32_t valid)
+{
+    // whatever beyond eof is visible to user via mmap, must not leak anything
+    valid = MIN(valid, PAGE_SIZE);
+    memset(pg->pg + valid, 0, PAGE_SIZE - valid);
+}
+
+static void
+__pcache_fill_done(void* arg, int result)
+{
+    struct pcache_pg* pg = (struct pcache_pg*)arg;
+    struct pcache* pcache = pg->holder;
+    u32_t fsize = pcache->master->fsize;
+
+    if (result < 0) {
+        pg->flags |= PCACHE_STALE;
+        result = 0;
+    }
+
+    // device reads in blocks, do not expose anything beyond eof
+    pg->len = pg->fpos < fsize ? MIN((u32_t)result, fsize - pg->fpos) : 0;
+    __pcache_zero_tail(pg, pg->len);
+    pg->flags &= ~PCACHE_INFLIGHT;
+    pcache->n_inflight--;
+
+    pwake_all(&pcache->inflight_wq);
+}
+
+static void
+__pcache_wait_page(struct pcache* pcache, struct pcache_pg* pg, u32_t flags)
+{
+    u32_t intr = cpu_save_interrupt();
+
+    while ((pg->flags & flags)) {
+        pwait(&pcache->inflight_wq);
+        cpu_disable_interrupt();
+    }
+
+    cpu_restore_interrupt(intr);
+}
+
 void
 pcache_init(struct pcache* pcache)
 {
-    btrie_init(&pcache->tree, PAGE_SHIFT);
+    radix_init(&pcache->tree);
     llist_init_head(&pcache->dirty);
     llist_init_head(&pcache->pages);
+    llist_init_head(&pcache->wb_list);
+    waitq_init(&pcache->inflight_wq);
 
-    pcache_zone = lru_new_zone(__pcache_try_evict);
+    if (!pcache_zone) {
+        pcache_zone =
+          lru_new_zone_2q("pcache", __pcache_try_evict, __pcache_key);
+    }
 }
 
 void
@@ -61,11 +205,12 @@ pcache_release_page(struct pcache* pcache, struct pcache_pg* page)
 
     llist_delete(&page->pg_list);
 
-    btrie_remove(&pcache->tree, page->fpos);
+    radix_remove(&pcache->tree, pg_index(page->fpos));
 
     vfree(page);
 
     pcache->n_pages--;
+    nr_cached--;
 }
 
 struct pcache_pg*
@@ -85,11 +230,16 @@ pcache_new_page(struct pcache* pcache, u32_t index)
         }
     }
 
+    if (radix_set(&pcache->tree, pg_index(index), ppg)) {
+        pcache_free_page(pg);
+        vfree(ppg);
+        return NULL;
+    }
+
     ppg->pg = pg;
     ppg->holder = pcache;
 
     llist_append(&pcache->pages, &ppg->pg_list);
-    btrie_set(&pcache->tree, index, ppg);
 
     return ppg;
 }
@@ -97,10 +247,24 @@ pcache_new_page(struct pcache* pcache, u32_t index)
 void
 pcache_set_dirty(struct pcache* pcache, struct pcache_pg* pg)
 {
-    if (!(pg->flags & PCACHE_DIRTY)) {
-        pg->flags |= PCACHE_DIRTY;
-        pcache->n_dirty++;
-        llist_append(&pcache->dirty, &pg->dirty_list);
+    if (pcache->resident || (pg->flags & PCACHE_DIRTY)) {
+        return;
+    }
+
+    pg->flags |= PCACHE_DIRTY;
+    pg->dirtied = clock_systime();
+    radix_tag_set(&pcache->tree, pg_index(pg->fpos), PCACHE_TAG_DIRTY);
+
+    if (!pcache->n_dirty++) {
+        llist_append(&dirty_caches, &pcache->wb_list);
+    }
+
+    // oldest first
+    llist_append(&pcache->dirty, &pg->dirty_list);
+    nr_dirty++;
+
+    if (__pcache_too_dirty()) {
+        __pcache_kick_writeback();
     }
 }
 
@@ -110,16 +274,17 @@ pcache_get_page(struct pcache* pcache,
                 u32_t* offset,
                 struct pcache_pg** page)
 {
-    struct pcache_pg* pg = btrie_get(&pcache->tree, index);
+    struct pcache_pg* pg = radix_get(&pcache->tree, pg_index(index));
     int is_new = 0;
-    u32_t mask = ((1 << pcache->tree.truncated) - 1);
+    u32_t mask = PAGE_SIZE - 1;
     *offset = index & mask;
     if (!pg && (pg = pcache_new_page(pcache, index))) {
         pg->fpos = index & ~mask;
         pcache->n_pages++;
+        nr_cached++;
         is_new = 1;
     }
-    if (pg)
+    if (pg && !pcache->resident)
         lru_use_one(pcache_zone, &pg->lru);
     *page = pg;
     return is_new;
@@ -131,13 +296,27 @@ pcache_write(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
     int errno = 0;
     u32_t pg_off, buf_off = 0;
     struct pcache* pcache = inode->pg_cache;
+    struct v_file_ops* fops = inode->default_fops;
     struct pcache_pg* pg;
 
+    if (fpos + len > inode->fsize && fops->truncate &&
+        (errno = fops->truncate(inode, fpos + len))) {
+        return errno;
+    }
+
     while (buf_off < len && errno >= 0) {
-        u32_t wr_bytes = MIN(PAGE_SIZE - pg_off, len - buf_off);
+        u32_t wr_bytes = MIN(PAGE_SIZE - (fpos % PAGE_SIZE), len - buf_off);
 
         int new_page = pcache_get_page(pcache, fpos, &pg_off, &pg);
 
+        if (!new_page && pg) {
+            __pcache_wait_page(pcache, pg, PCACHE_INFLIGHT);
+            if ((pg->flags & PCACHE_STALE)) {
+                pg->flags &= ~PCACHE_STALE;
+                new_page = 1;
+            }
+        }
+
         if (new_page) {
             // Filling up the page
             errno = inode->default_fops->read_page(inode, pg->pg, pg->fpos);
@@ -145,36 +324,172 @@ pcache_write(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
             if (errno < 0) {
                 break;
             }
-            if (errno < (int)PAGE_SIZE) {
-                // EOF
-                len = MIN(len, buf_off + errno);
-            }
+
+            // writing beyond eof is fine, it extends the file
+            pg->len = errno;
+            __pcache_zero_tail(pg, pg->len);
         } else if (!pg) {
-            errno = inode->default_fops->write(inode, data, wr_bytes, fpos);
+            // no page to cache it, write through
+            if (pcache->resident) {
+                errno = ENOMEM;
+                break;
+            }
+
+            errno = fops->write(inode, data + buf_off, wr_bytes, fpos);
+            if (errno <= 0) {
+                // nothing written, report what we have got so far
+                break;
+            }
+
+            buf_off += errno;
+            fpos += errno;
             continue;
         }
 
         memcpy(pg->pg + pg_off, (data + buf_off), wr_bytes);
         pcache_set_dirty(pcache, pg);
 
-        pg->len = pg_off + wr_bytes;
+        pg->len = MAX(pg->len, pg_off + wr_bytes);
         buf_off += wr_bytes;
         fpos += wr_bytes;
     }
 
-    return errno < 0 ? errno : (int)buf_off;
+    if (errno < 0) {
+        return errno;
+    }
+
+    inode->fsize = MAX(inode->fsize, fpos);
+    return (int)buf_off;
+}
+
+/**
+ * @brief Prefetch pages in [start, end) that are not cached without waiting
+ * for them.
+ *
+ * @return u32_t where the prefetch actually stopped
+ */
+static u32_t
+__pcache_prefetch(struct v_inode* inode, u32_t start, u32_t end)
+{
+    int errno;
+    u32_t pg_off;
+    struct pcache* pcache = inode->pg_cache;
+    struct pcache_pg* pg;
+
+    for (; start < end; start += PAGE_SIZE) {
+        if (radix_get(&pcache->tree, pg_index(start))) {
+            continue;
+        }
+
+        if (!pcache_get_page(pcache, start, &pg_off, &pg)) {
+            break;
+        }
+
+        pg->flags |= PCACHE_INFLIGHT;
+        pcache->n_inflight++;
+
+        errno = inode->default_fops->read_page_async(
+          inode, pg->pg, pg->fpos, __pcache_fill_done, pg);
+
+        if (!errno) {
+            // nothing to read, will not be called back.
+            __pcache_fill_done(pg, 0);
+        } else if (errno < 0) {
+            pg->flags &= ~PCACHE_INFLIGHT;
+            pcache->n_inflight--;
+
+            lru_remove(pcache_zone, &pg->lru);
+            pcache_release_page(pcache, pg);
+            break;
+        }
+    }
+
+    return start;
+}
+
+/**
+ * @brief Adjust the readahead window based on whether this read continues
+ * the previous one and issue the prefetch accordingly.
+ *
+ */
+static void
+__pcache_readahead(struct v_inode* inode,
+                   struct pcache_ra* ra,
+                   u32_t len,
+                   u32_t fpos)
+{
+    u32_t start = ROUNDDOWN(fpos, PAGE_SIZE);
+    u32_t end, limit;
+    struct blkio_plug plug;
+
+    if (!inode->default_fops->read_page_async) {
+        return;
+    }
+
+    if (start == ra->next) {
+        ra->window = ra->window ? MIN(ra->window * 2, PCACHE_RA_MAX)
+                                : PCACHE_RA_MIN;
+        start = MAX(start, ra->ahead);
+    } else {
+        ra->window = ra->window / 2;
+        ra->ahead = 0;
+    }
+
+    ra->next = ROUNDDOWN(fpos + len, PAGE_SIZE);
+
+    if (!ra->window) {
+        return;
+    }
+
+    limit = ROUNDUP(inode->fsize, PAGE_SIZE);
+    end = ROUNDUP(fpos + len, PAGE_SIZE) + ra->window * PAGE_SIZE;
+    end = MIN(end, limit);
+
+    if (start >= end) {
+        return;
+    }
+
+    // let the whole window queue up, so it can be merged before dispatch
+    blkio_plug(&plug);
+    ra->ahead = __pcache_prefetch(inode, start, end);
+    blkio_unplug(&plug);
+
+    if (ra->ahead < end) {
+        // not prefetchable for now, back off.
+        ra->window = 0;
+    }
 }
 
 int
-pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
+pcache_read(struct v_inode* inode,
+            struct pcache_ra* ra,
+            void* data,
+            u32_t len,
+            u32_t fpos)
 {
     u32_t pg_off, buf_off = 0, new_pg = 0;
     int errno = 0;
     struct pcache* pcache = inode->pg_cache;
     struct pcache_pg* pg;
 
+    if (pcache->resident) {
+        // nothing behind the cache, holes read as zero up to eof.
+        len = fpos < inode->fsize ? MIN(len, inode->fsize - fpos) : 0;
+    } else if (ra) {
+        __pcache_readahead(inode, ra, len, fpos);
+    }
+
     while (buf_off < len) {
         int new_page = pcache_get_page(pcache, fpos, &pg_off, &pg);
+
+        if (!new_page && pg) {
+            __pcache_wait_page(pcache, pg, PCACHE_INFLIGHT);
+            if ((pg->flags & PCACHE_STALE)) {
+                pg->flags &= ~PCACHE_STALE;
+                new_page = 1;
+            }
+        }
+
         if (new_page) {
             // Filling up the page
             errno = inode->default_fops->read_page(inode, pg->pg, pg->fpos);
@@ -188,14 +503,25 @@ pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
             }
 
             pg->len = errno;
+            __pcache_zero_tail(pg, pg->len);
         } else if (!pg) {
+            if (pcache->resident) {
+                errno = ENOMEM;
+                break;
+            }
+
             errno = inode->default_fops->read(
-              inode, (data + buf_off), len - buf_off, pg->fpos);
+              inode, (data + buf_off), len - buf_off, fpos);
             buf_off = len;
             break;
         }
 
-        u32_t rd_bytes = MIN(pg->len - pg_off, len - buf_off);
+        u32_t valid = pcache->resident ? PAGE_SIZE : pg->len;
+
+        if (valid <= pg_off)
+            break;
+
+        u32_t rd_bytes = MIN(valid - pg_off, len - buf_off);
 
         if (!rd_bytes)
             break;
@@ -209,32 +535,158 @@ pcache_read(struct v_inode* inode, void* data, u32_t len, u32_t fpos)
     return errno < 0 ? errno : (int)buf_off;
 }
 
+struct pcache_pg*
+pcache_lookup(struct pcache* pcache, u32_t fpos)
+{
+    return radix_get(&pcache->tree, pg_index(fpos));
+}
+
+int
+pcache_map_page(struct v_inode* inode, u32_t fpos, struct leaflet** leaflet)
+{
+    int errno;
+    u32_t pg_off;
+    struct pcache* pcache = inode->pg_cache;
+    struct pcache_pg* pg;
+
+    int new_page = pcache_get_page(pcache, fpos, &pg_off, &pg);
+
+    if (!pg) {
+        return ENOMEM;
+    }
+
+    if (!new_page) {
+        __pcache_wait_page(pcache, pg, PCACHE_INFLIGHT);
+        new_page = !!(pg->flags & PCACHE_STALE);
+    }
+
+    if (new_page) {
+        errno = inode->default_fops->read_page(inode, pg->pg, pg->fpos);
+
+        if (errno < 0) {
+            // leave it for whoever comes next to retry
+            pg->flags |= PCACHE_STALE;
+            return errno;
+        }
+
+        pg->flags &= ~PCACHE_STALE;
+        pg->len = MIN((u32_t)errno, PAGE_SIZE);
+        __pcache_zero_tail(pg, pg->len);
+    }
+
+    *leaflet = __pcache_leaflet(pg->pg);
+    leaflet_borrow(*leaflet);
+
+    return 0;
+}
+
+bool
+pcache_map_cached(struct v_inode* inode, u32_t fpos, struct leaflet** leaflet)
+{
+    struct pcache_pg* pg = radix_get(&inode->pg_cache->tree, pg_index(fpos));
+
+    if (!pg || (pg->flags & (PCACHE_INFLIGHT | PCACHE_STALE))) {
+        return false;
+    }
+
+    if (!inode->pg_cache->resident) {
+        lru_use_one(pcache_zone, &pg->lru);
+    }
+
+    *leaflet = __pcache_leaflet(pg->pg);
+    leaflet_borrow(*leaflet);
+
+    return true;
+}
+
+void
+pcache_prefetch(struct v_inode* inode, u32_t start, u32_t end)
+{
+    if (!inode->default_fops->read_page_async) {
+        return;
+    }
+
+    start = ROUNDDOWN(start, PAGE_SIZE);
+    end = MIN(end, ROUNDUP(inode->fsize, PAGE_SIZE));
+
+    __pcache_prefetch(inode, start, end);
+}
+
 void
 pcache_release(struct pcache* pcache)
 {
     struct pcache_pg *pos, *n;
+    u32_t intr = cpu_save_interrupt();
+
+    // in-flight prefetch still referencing the pages
+    while (pcache->n_inflight) {
+        pwait(&pcache->inflight_wq);
+        cpu_disable_interrupt();
+    }
+
+    cpu_restore_interrupt(intr);
+
+    llist_delete(&pcache->wb_list);
+    nr_dirty -= pcache->n_dirty;
+    nr_cached -= pcache->n_pages;
+
     llist_for_each(pos, n, &pcache->pages, pg_list)
     {
         lru_remove(pcache_zone, &pos->lru);
+        pcache_free_page(pos->pg);
         vfree(pos);
     }
 
-    btrie_release(&pcache->tree);
+    radix_release(&pcache->tree);
+}
+
+void
+pcache_truncate(struct pcache* pcache, u32_t size)
+{
+    struct pcache_pg* pgs[PCACHE_WB_BATCH];
+    struct pcache_pg* pg;
+    u32_t valid = size % PAGE_SIZE;
+    size_t n;
+
+    if (valid && (pg = radix_get(&pcache->tree, pg_index(size)))) {
+        __pcache_wait_page(pcache, pg, PCACHE_INFLIGHT);
+        __pcache_zero_tail(pg, valid);
+        pg->len = MIN(pg->len, valid);
+    }
+
+    while ((n = radix_gang_lookup(&pcache->tree,
+                                  (void**)pgs,
+                                  pg_index(ROUNDUP(size, PAGE_SIZE)),
+                                  PCACHE_WB_BATCH))) {
+        for (size_t i = 0; i < n; i++) {
+            pg = pgs[i];
+            __pcache_wait_page(pcache, pg, PCACHE_INFLIGHT | PCACHE_WRITEBACK);
+
+            if ((pg->flags & PCACHE_DIRTY)) {
+                __pcache_clear_dirty(pcache, pg);
+            }
+
+            lru_remove(pcache_zone, &pg->lru);
+            pcache_release_page(pcache, pg);
+        }
+    }
 }
 
 int
 pcache_commit(struct v_inode* inode, struct pcache_pg* page)
 {
+    // whatever being written back must land before we return
+    __pcache_wait_page(inode->pg_cache, page, PCACHE_WRITEBACK);
+
     if (!(page->flags & PCACHE_DIRTY)) {
         return 0;
     }
 
     int errno = inode->default_fops->write_page(inode, page->pg, page->fpos);
 
-    if (!errno) {
-        page->flags &= ~PCACHE_DIRTY;
-        llist_delete(&page->dirty_list);
-        inode->pg_cache->n_dirty--;
+    if (errno >= 0) {
+        __pcache_clear_dirty(inode->pg_cache, page);
+        errno = 0;
     }
 
     return errno;
@@ -248,12 +700,33 @@ pcache_commit_all(struct v_inode* inode)
     }
 
     struct pcache* cache = inode->pg_cache;
-    struct pcache_pg *pos, *n;
+    struct pcache_pg* pg;
+    u32_t intr = cpu_save_interrupt();
+
+    do {
+        // commit might block, leaving writeback thread free to take pages
+        //  off the list meanwhile, thus restart from head every time.
+        while (!llist_empty(&cache->dirty)) {
+            pg = list_entry(cache->dirty.next, struct pcache_pg, dirty_list);
+            if (pcache_commit(inode, pg)) {
+                goto done;
+            }
+            cpu_disable_interrupt();
+        }
 
-    llist_for_each(pos, n, &cache->dirty, dirty_list)
-    {
-        pcache_commit(inode, pos);
-    }
+        // those taken by writeback thread are off the list, but not yet
+        //  landed.
+        while (radix_gang_lookup_tag(
+          &cache->tree, (void**)&pg, 0, 1, PCACHE_TAG_WRITEBACK)) {
+            pwait(&cache->inflight_wq);
+            cpu_disable_interrupt();
+        }
+
+        // failed writeback put the pages back to dirty
+    } while (!llist_empty(&cache->dirty));
+
+done:
+    cpu_restore_interrupt(intr);
 }
 
 void
@@ -261,4 +734,182 @@ pcache_invalidate(struct pcache* pcache, struct pcache_pg* page)
 {
     pcache_commit(pcache->master, page);
     pcache_release_page(pcache, page);
-}
\ No newline at end of file
+}
+/**
+ * @brief Take a run of file-contiguous dirty pages around `pg` out of the
+ * dirty set, marking them as being written back.
+ *
+ * @return u32_t file offset of the run
+ */
+static u32_t
+__pcache_take_run(struct pcache* pcache,
+                  struct pcache_pg* pg,
+                  struct vecbuf** vbuf)
+{
+    struct pcache_pg* run[PCACHE_WB_BATCH];
+    struct radix_tree* tree = &pcache->tree;
+    u32_t start = pg_index(pg->fpos), idx;
+    size_t n, i;
+
+    // extend backward to the beginning of the dirty run
+    while (start && pg_index(pg->fpos) - start < PCACHE_WB_BATCH - 1) {
+        idx = start - 1;
+        if (!radix_tag_get(tree, idx, PCACHE_TAG_DIRTY) ||
+            radix_tag_get(tree, idx, PCACHE_TAG_WRITEBACK)) {
+            break;
+        }
+        start = idx;
+    }
+
+    n = radix_gang_lookup_tag(
+      tree, (void**)run, start, PCACHE_WB_BATCH, PCACHE_TAG_DIRTY);
+
+    for (i = 0; i < n; i++) {
+        if (pg_index(run[i]->fpos) != start + i ||
+            (run[i]->flags & PCACHE_WRITEBACK)) {
+            break;
+        }
+
+        __pcache_clear_dirty(pcache, run[i]);
+        run[i]->flags |= PCACHE_WRITEBACK;
+        radix_tag_set(tree, start + i, PCACHE_TAG_WRITEBACK);
+        pcache->n_inflight++;
+
+        vbuf_alloc(vbuf, run[i]->pg, PAGE_SIZE);
+    }
+
+    assert(i);
+    return start * PAGE_SIZE;
+}
+
+static void
+__pcache_write_run(struct pcache* pcache, struct vecbuf* vbuf, u32_t start)
+{
+    int errno = ENOTSUP;
+    struct pcache_pg* pg;
+    struct v_inode* inode = pcache->master;
+    struct v_file_ops* fops = inode->default_fops;
+    u32_t end = start + vbuf_size(vbuf), fpos;
+
+    if (fops->write_pages) {
+        errno = fops->write_pages(inode, vbuf, start);
+    }
+
+    for (fpos = start; fpos < end; fpos += PAGE_SIZE) {
+        pg = radix_get(&pcache->tree, pg_index(fpos));
+
+        if (errno < 0 &&
+            (!fops->write_page || fops->write_page(inode, pg->pg, fpos) < 0)) {
+            // try again later.
+            cpu_disable_interrupt();
+            pcache_set_dirty(pcache, pg);
+            cpu_enable_interrupt();
+        }
+
+        cpu_disable_interrupt();
+        pg->flags &= ~PCACHE_WRITEBACK;
+        radix_tag_clear(&pcache->tree, pg_index(fpos), PCACHE_TAG_WRITEBACK);
+        cpu_enable_interrupt();
+    }
+
+    /*
+        The run keeps the cache alive through n_inflight. Once it drops,
+        a waiter in pcache_release is free to tear the cache down, so
+        drop it and wake them in one go, and never touch pcache after.
+    */
+    cpu_disable_interrupt();
+    pcache->n_inflight -= (end - start) / PAGE_SIZE;
+    pwake_all(&pcache->inflight_wq);
+    cpu_enable_interrupt();
+
+    vbuf_free(vbuf);
+}
+
+/**
+ * @brief Flush one run of dirty pages dirtied no later than `cutoff`
+ *
+ * @return u32_t number of pages flushed
+ */
+static u32_t
+__pcache_flush_one(time_t cutoff)
+{
+    struct pcache *pos, *n;
+    struct pcache_pg* oldest;
+    struct vecbuf* vbuf = NULL;
+    u32_t start, nr_pages;
+
+    cpu_disable_interrupt();
+
+    llist_for_each(pos, n, &dirty_caches, wb_list)
+    {
+        oldest = list_entry(pos->dirty.next, struct pcache_pg, dirty_list);
+        if (oldest->dirtied > cutoff) {
+            continue;
+        }
+
+        start = __pcache_take_run(pos, oldest, &vbuf);
+        nr_pages = vbuf_size(vbuf) / PAGE_SIZE;
+
+        // round robin among caches
+        if (!llist_empty(&pos->wb_list)) {
+            llist_delete(&pos->wb_list);
+            llist_append(&dirty_caches, &pos->wb_list);
+        }
+
+        cpu_enable_interrupt();
+
+        __pcache_write_run(pos, vbuf, start);
+        return nr_pages;
+    }
+
+    cpu_enable_interrupt();
+    return 0;
+}
+
+static void
+__pcache_writeback_doze()
+{
+    struct haybed* bed = &current_thread->sleep;
+    ticks_t interval = hwtimer_to_ticks(PCACHE_WB_INTERVAL, TIME_MS);
+
+    cpu_disable_interrupt();
+
+    // no timer to wake us, better keep writing than sleep forever.
+    if (!__pcache_too_dirty() && !timer_arm(&bed->wakeup, interval)) {
+        wb_dozing = true;
+        block_current_thread();
+        sched_pass();
+
+        // woken early, do not let the timer disturb us later.
+        cpu_disable_interrupt();
+        wb_dozing = false;
+        timer_disarm(&bed->wakeup);
+    }
+
+    cpu_enable_interrupt();
+}
+
+void _preemptible
+pcache_writeback_main()
+{
+    time_t cutoff;
+    u32_t budget, flushed;
+
+    wb_thread = current_thread;
+
+    while (1) {
+        __pcache_writeback_doze();
+
+        // everything dirty if we are under pressure, otherwise the aged.
+        cutoff = clock_systime();
+        if (!__pcache_too_dirty()) {
+            cutoff = cutoff > PCACHE_WB_EXPIRE ? cutoff - PCACHE_WB_EXPIRE : 0;
+        }
+
+        // a page failed to write is redirtied, make sure we can stop.
+        budget = nr_dirty;
+        while (budget && (flushed = __pcache_flush_one(cutoff))) {
+            budget -= MIN(budget, flushed);
+        }
+    }
+}
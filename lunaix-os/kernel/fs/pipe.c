@@ -0,0 +1,521 @@
+/**
+ * @file pipe.c
+ * @brief Anonymous pipe. Both ends are nameless inodes of a private pseudo
+ * fs, which is never mounted anywhere.
+ *
+ */
+#include <lunaix/fs.h>
+#include <lunaix/fs/pipe.h>
+#include <lunaix/iopoll.h>
+#include <lunaix/mm/page.h>
+#include <lunaix/mm/valloc.h>
+#include <lunaix/mm/vmm.h>
+#include <lunaix/process.h>
+#include <lunaix/signal.h>
+#include <lunaix/spike.h>
+#include <lunaix/status.h>
+#include <lunaix/syscall.h>
+#include <lunaix/syscall_utils.h>
+
+#include <usr/lunaix/fcntl_defs.h>
+
+#include <sys/cpu.h>
+
+#include <klibc/string.h>
+
+static struct v_superblock* pipe_sb;
+static struct v_dnode* pipe_root;
+static struct v_mount pipe_mnt;
+static volatile inode_t pipe_ino = 0;
+
+static struct v_inode_ops pipe_inode_ops;
+static struct v_file_ops pipe_rd_fops;
+static struct v_file_ops pipe_wr_fops;
+
+static inline struct pipe_slot*
+__pipe_slot(struct pipe* pipe, u32_t i)
+{
+    return &pipe->ring[i % PIPE_SLOTS];
+}
+
+static inline bool
+__pipe_interrupted()
+{
+    return sigset_test(pending_sigs(current_thread), _SIGINT);
+}
+
+static u32_t
+__pipe_room(struct pipe* pipe)
+{
+    u32_t used = pipe->head - pipe->tail;
+    u32_t room = (PIPE_SLOTS - used) * PAGE_SIZE;
+
+    if (used) {
+        room += PAGE_SIZE - __pipe_slot(pipe, pipe->head - 1)->end;
+    }
+
+    return room;
+}
+
+static void*
+__pipe_alloc_page()
+{
+    struct leaflet* leaflet = alloc_leaflet(0);
+    void* pg;
+
+    if (!leaflet) {
+        return NULL;
+    }
+
+    if (!(pg = (void*)vmap(leaflet, KERNEL_DATA))) {
+        leaflet_return(leaflet);
+        return NULL;
+    }
+
+    return pg;
+}
+
+static void
+__pipe_free_page(void* pg)
+{
+    struct leaflet* leaflet;
+
+    leaflet = pte_leaflet(pte_at(mkptep_va(VMS_SELF, (ptr_t)pg)));
+    vunmap((ptr_t)pg, leaflet);
+    leaflet_return(leaflet);
+}
+
+static void
+__pipe_notify(struct pipe* pipe, waitq_t* waitq)
+{
+    pwake_all(waitq);
+    iopoll_wake_pollers(&pipe->pollers);
+}
+
+/**
+ * @brief Copy in as much of `buf` as the ring can hold.
+ *
+ * @return int bytes taken, or ENOMEM if not even one
+ */
+static int
+__pipe_push(struct pipe* pipe, u8_t* buf, u32_t len)
+{
+    struct pipe_slot* slot = __pipe_slot(pipe, pipe->head - 1);
+    u32_t n, done = 0;
+
+    while (done < len) {
+        if (pipe->head == pipe->tail || slot->end == PAGE_SIZE) {
+            if (pipe->head - pipe->tail == PIPE_SLOTS) {
+                break;
+            }
+
+            slot = __pipe_slot(pipe, pipe->head);
+            if (!slot->pg && !(slot->pg = __pipe_alloc_page())) {
+                return done ? (int)done : ENOMEM;
+            }
+
+            slot->start = 0;
+            slot->end = 0;
+            pipe->head++;
+        }
+
+        n = MIN(len - done, PAGE_SIZE - slot->end);
+        memcpy((u8_t*)slot->pg + slot->end, &buf[done], n);
+
+        slot->end += n;
+        pipe->avail += n;
+        done += n;
+    }
+
+    return done;
+}
+
+/**
+ * @brief Copy out at most `len` bytes, whole slots are retired once drained.
+ *
+ * @return u32_t bytes copied
+ */
+static u32_t
+__pipe_pop(struct pipe* pipe, u8_t* buf, u32_t len)
+{
+    struct pipe_slot* slot;
+    u32_t n, done = 0;
+
+    while (done < len && pipe->head != pipe->tail) {
+        slot = __pipe_slot(pipe, pipe->tail);
+
+        n = MIN(len - done, slot->end - slot->start);
+        memcpy(&buf[done], (u8_t*)slot->pg + slot->start, n);
+
+        slot->start += n;
+        pipe->avail -= n;
+        done += n;
+
+        // writer is still filling it
+        if (slot->start < slot->end || slot->end < PAGE_SIZE) {
+            break;
+        }
+
+        pipe->tail++;
+    }
+
+    return done;
+}
+
+static void
+__pipe_hangup(struct pipe* pipe)
+{
+    pwake_all(&pipe->rd_wait);
+    pwake_all(&pipe->wr_wait);
+    iopoll_wake_pollers(&pipe->pollers);
+
+    if (pipe->reader || pipe->writer) {
+        return;
+    }
+
+    for (int i = 0; i < PIPE_SLOTS; i++) {
+        if (pipe->ring[i].pg) {
+            __pipe_free_page(pipe->ring[i].pg);
+            pipe->ring[i].pg = NULL;
+        }
+    }
+}
+
+static int
+pipe_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    struct pipe* pipe = PIPE(inode->data);
+    u32_t intr;
+    int n;
+
+    if (!len) {
+        return 0;
+    }
+
+    // a writer must not sneak in between the check and the wait
+    intr = cpu_save_interrupt();
+
+    while (!(n = __pipe_pop(pipe, (u8_t*)buffer, len))) {
+        if (!pipe->writer) {
+            break;
+        }
+
+        if ((pipe->flags & PIPE_NONBLOCK)) {
+            n = EAGAIN;
+            break;
+        }
+
+        pwait(&pipe->rd_wait);
+        cpu_disable_interrupt();
+
+        if (__pipe_interrupted()) {
+            n = EINTR;
+            break;
+        }
+    }
+
+    if (n > 0) {
+        __pipe_notify(pipe, &pipe->wr_wait);
+    }
+
+    cpu_restore_interrupt(intr);
+
+    return n;
+}
+
+static int
+pipe_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    struct pipe* pipe = PIPE(inode->data);
+    u8_t* buf = (u8_t*)buffer;
+    size_t done = 0;
+    int n, errno = 0;
+    u32_t intr;
+
+    // a reader must not sneak in between the check and the wait
+    intr = cpu_save_interrupt();
+
+    while (done < len) {
+        if (!pipe->reader) {
+            errno = EPIPE;
+            break;
+        }
+
+        n = 0;
+        // small write goes in one piece
+        if (len > PIPE_BUF || __pipe_room(pipe) >= len) {
+            n = __pipe_push(pipe, &buf[done], len - done);
+        }
+
+        if (n < 0) {
+            errno = n;
+            break;
+        }
+
+        if (n) {
+            done += n;
+            __pipe_notify(pipe, &pipe->rd_wait);
+            continue;
+        }
+
+        if ((pipe->flags & PIPE_NONBLOCK)) {
+            errno = EAGAIN;
+            break;
+        }
+
+        pwait(&pipe->wr_wait);
+        cpu_disable_interrupt();
+
+        if (__pipe_interrupted()) {
+            errno = EINTR;
+            break;
+        }
+    }
+
+    cpu_restore_interrupt(intr);
+
+    return done ? (int)done : errno;
+}
+
+static int
+pipe_badio(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    return EBADF;
+}
+
+static int
+pipe_rd_close(struct v_file* file)
+{
+    struct pipe* pipe = PIPE(file->inode->data);
+
+    pipe->reader = false;
+    __pipe_hangup(pipe);
+
+    return 0;
+}
+
+static int
+pipe_wr_close(struct v_file* file)
+{
+    struct pipe* pipe = PIPE(file->inode->data);
+
+    pipe->writer = false;
+    __pipe_hangup(pipe);
+
+    return 0;
+}
+
+static int
+pipe_rd_poll(struct v_file* file, struct llist_header** pollers)
+{
+    struct pipe* pipe = PIPE(file->inode->data);
+    int evt = 0;
+
+    if (pollers) {
+        *pollers = &pipe->pollers;
+    }
+
+    if (pipe->avail) {
+        evt |= _POLLIN;
+    }
+
+    if (!pipe->writer) {
+        evt |= _POLLHUP;
+    }
+
+    return evt;
+}
+
+static int
+pipe_wr_poll(struct v_file* file, struct llist_header** pollers)
+{
+    struct pipe* pipe = PIPE(file->inode->data);
+    int evt = 0;
+
+    if (pollers) {
+        *pollers = &pipe->pollers;
+    }
+
+    if (__pipe_room(pipe) >= PIPE_BUF) {
+        evt |= _POLLOUT;
+    }
+
+    if (!pipe->reader) {
+        evt |= _POLLERR;
+    }
+
+    return evt;
+}
+
+static int
+pipe_open(struct v_inode* this, struct v_file* file)
+{
+    return 0;
+}
+
+static void
+pipe_inode_destruct(struct v_inode* inode)
+{
+    struct pipe* pipe = PIPE(inode->data);
+
+    if (pipe && !--pipe->refs) {
+        vfree(pipe);
+    }
+}
+
+static void
+pipe_inode_init(struct v_superblock* vsb, struct v_inode* inode)
+{
+    inode->id = pipe_ino++;
+    inode->itype = VFS_IFPIPE;
+    inode->ops = &pipe_inode_ops;
+    inode->destruct = pipe_inode_destruct;
+}
+
+static int
+__pipe_open_end(struct pipe* pipe,
+                struct v_file_ops* fops,
+                struct v_file** file)
+{
+    struct v_inode* inode;
+    int errno;
+
+    if (!(inode = vfs_i_alloc(pipe_sb))) {
+        return ENOMEM;
+    }
+
+    inode->default_fops = fops;
+
+    if ((errno = vfs_open_anon(pipe_root, inode, file))) {
+        vfs_i_free(inode);
+        return errno;
+    }
+
+    inode->data = pipe;
+    pipe->refs++;
+
+    return 0;
+}
+
+static int
+__pipe_create(int* fds, int flags)
+{
+    struct v_file *rd_file = NULL, *wr_file = NULL;
+    struct pipe* pipe;
+    int errno, rd_fd = -1, wr_fd;
+
+    if ((flags & ~FO_NONBLOCK)) {
+        return EINVAL;
+    }
+
+    if (!(pipe = vzalloc(sizeof(*pipe)))) {
+        return ENOMEM;
+    }
+
+    waitq_init(&pipe->rd_wait);
+    waitq_init(&pipe->wr_wait);
+    llist_init_head(&pipe->pollers);
+    pipe->reader = true;
+    pipe->writer = true;
+
+    if ((flags & FO_NONBLOCK)) {
+        pipe->flags |= PIPE_NONBLOCK;
+    }
+
+    // the inode opened is pinned, and frees the pipe with it from now on
+    if ((errno = __pipe_open_end(pipe, &pipe_rd_fops, &rd_file))) {
+        vfree(pipe);
+        return errno;
+    }
+
+    if ((errno = __pipe_open_end(pipe, &pipe_wr_fops, &wr_file))) {
+        goto fail;
+    }
+
+    if ((errno = rd_fd = vfs_install_fd(rd_file, FO_RDONLY | flags)) < 0) {
+        goto fail;
+    }
+
+    if ((errno = wr_fd = vfs_install_fd(wr_file, FO_WRONLY | flags)) < 0) {
+        goto fail;
+    }
+
+    fds[0] = rd_fd;
+    fds[1] = wr_fd;
+
+    return 0;
+
+fail:
+    if (rd_fd >= 0) {
+        vfs_free_fd(__current->fdtable->fds[rd_fd]);
+        __current->fdtable->fds[rd_fd] = NULL;
+    }
+
+    if (wr_file) {
+        vfs_close(wr_file);
+    } else {
+        pipe->writer = false;
+    }
+
+    vfs_close(rd_file);
+
+    return errno;
+}
+
+void
+pipefs_init()
+{
+    struct hstr name = HSTR("pipe:", 5);
+
+    pipe_sb = vfs_sb_alloc();
+    pipe_sb->fs = fsm_new_fs("pipefs", -1);
+    pipe_sb->blksize = PAGE_SIZE;
+    pipe_sb->ops.init_inode = pipe_inode_init;
+
+    pipe_root = vfs_d_alloc(NULL, &name);
+    pipe_root->parent = pipe_root;
+    pipe_root->super_block = pipe_sb;
+    pipe_root->mnt = &pipe_mnt;
+    atomic_fetch_add(&pipe_root->ref_count, 1);
+
+    pipe_sb->root = pipe_root;
+
+    // not in the mount tree, there is just nothing to be seen
+    mutex_init(&pipe_mnt.lock);
+    llist_init_head(&pipe_mnt.list);
+    llist_init_head(&pipe_mnt.submnts);
+    llist_init_head(&pipe_mnt.sibmnts);
+    pipe_mnt.mnt_point = pipe_root;
+    pipe_mnt.super_block = pipe_sb;
+}
+EXPORT_FILE_SYSTEM(pipefs, pipefs_init);
+
+__DEFINE_LXSYSCALL2(int, pipe2, int*, fds, int, flags)
+{
+    int errno = __pipe_create(fds, flags);
+    return DO_STATUS(errno);
+}
+
+__DEFINE_LXSYSCALL1(int, pipe, int*, fds)
+{
+    int errno = __pipe_create(fds, 0);
+    return DO_STATUS(errno);
+}
+
+static struct v_inode_ops pipe_inode_ops = {
+    .open = pipe_open,
+};
+
+static struct v_file_ops pipe_rd_fops = {
+    .read = pipe_read,
+    .write = pipe_badio,
+    .close = pipe_rd_close,
+    .poll = pipe_rd_poll,
+};
+
+static struct v_file_ops pipe_wr_fops = {
+    .read = pipe_badio,
+    .write = pipe_write,
+    .close = pipe_wr_close,
+    .poll = pipe_wr_poll,
+};
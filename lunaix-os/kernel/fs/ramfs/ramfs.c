@@ -11,6 +11,7 @@
 #include <klibc/string.h>
 #include <lunaix/fs.h>
 #include <lunaix/fs/ramfs.h>
+#include <lunaix/mm/page.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/spike.h>
 
@@ -39,13 +40,32 @@
     On the other hand, RamFS is designed to be act like a dummy fs
     that just ensure 'something there at least' and thus provide basic
     'mountibility' for other fs.
+
+    Content of regular file lives in its page cache only. Such cache is
+    marked as resident, pages are never evicted nor written back, and a
+    page missing from the cache is a hole. Space is accounted by file size
+    against CONFIG_RAMFS_MAX_PAGES.
 */
 
+#define RAMFS_PAGES(size) (ROUNDUP((size), PAGE_SIZE) / PAGE_SIZE)
+
 static volatile inode_t ino = 0;
 
 extern const struct v_inode_ops ramfs_inode_ops;
 extern const struct v_file_ops ramfs_file_ops;
 
+static void
+ramfs_inode_destruct(struct v_inode* inode)
+{
+    struct ram_inode* rinode = RAM_INODE(inode->data);
+
+    if ((rinode->flags & RAMF_SYMLINK)) {
+        vfree(rinode->symlink);
+    }
+
+    vfree(rinode);
+}
+
 static int
 __ramfs_mknod(struct v_dnode* dnode, struct v_inode** nod_out, u32_t flags)
 {
@@ -64,6 +84,7 @@ __ramfs_mknod(struct v_dnode* dnode, struct v_inode** nod_out, u32_t flags)
 
     rinode->flags = flags;
     inode->data = rinode;
+    inode->destruct = ramfs_inode_destruct;
 
     if (!(flags & RAMF_DIR)) {
         inode->itype = VFS_IFFILE;
@@ -84,33 +105,88 @@ __ramfs_mknod(struct v_dnode* dnode, struct v_inode** nod_out, u32_t flags)
 }
 
 int
-ramfs_readdir(struct v_file* file, struct dir_context* dctx)
-{
-    int i = 0;
-    struct v_dnode *pos, *n;
-    llist_for_each(pos, n, &file->dnode->children, siblings)
-    {
-        if (i++ >= dctx->index) {
-            dctx->read_complete_callback(dctx,
-                                         pos->name.value,
-                                         pos->name.len,
-                                         vfs_get_dtype(pos->inode->itype));
-            return 1;
-        }
+ramfs_mkdir(struct v_inode* this, struct v_dnode* dnode)
+{
+    return __ramfs_mknod(dnode, NULL, RAMF_DIR);
+}
+
+int
+ramfs_create(struct v_inode* this, struct v_dnode* dnode)
+{
+    return __ramfs_mknod(dnode, NULL, RAMF_FILE);
+}
+
+int
+ramfs_open(struct v_inode* this, struct v_file* file)
+{
+    if (this->pg_cache) {
+        this->pg_cache->resident = true;
     }
+
     return 0;
 }
 
 int
-ramfs_mkdir(struct v_inode* this, struct v_dnode* dnode)
+ramfs_truncate(struct v_inode* inode, size_t size)
 {
-    return __ramfs_mknod(dnode, NULL, RAMF_DIR);
+    struct ram_sb* rsb = RAM_SB(inode->sb->data);
+    u32_t old_pgs = RAMFS_PAGES(inode->fsize), new_pgs = RAMFS_PAGES(size);
+
+    if (new_pgs > old_pgs &&
+        new_pgs - old_pgs > rsb->max_pages - rsb->used_pages) {
+        return ENOSPC;
+    }
+
+    rsb->used_pages = rsb->used_pages - old_pgs + new_pgs;
+
+    // when growing, whatever mmap left beyond the old eof must not show up.
+    if (inode->pg_cache) {
+        pcache_truncate(inode->pg_cache, MIN(size, inode->fsize));
+    }
+
+    inode->fsize = size;
+
+    return 0;
 }
 
 int
-ramfs_create(struct v_inode* this, struct v_dnode* dnode)
+ramfs_read(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
 {
-    return __ramfs_mknod(dnode, NULL, RAMF_FILE);
+    return pcache_read(inode, NULL, buffer, len, fpos);
+}
+
+int
+ramfs_write(struct v_inode* inode, void* buffer, size_t len, size_t fpos)
+{
+    return pcache_write(inode, buffer, len, fpos);
+}
+
+int
+ramfs_read_page(struct v_inode* inode, void* pg, size_t fpos)
+{
+    // a hole
+    memset(pg, 0, PAGE_SIZE);
+
+    return fpos < inode->fsize ? MIN(inode->fsize - fpos, PAGE_SIZE) : 0;
+}
+
+int
+ramfs_write_page(struct v_inode* inode, void* pg, size_t fpos)
+{
+    // page cache is the storage
+    return 0;
+}
+
+u32_t
+ramfs_rd_capacity(struct v_superblock* vsb)
+{
+    return RAM_SB(vsb->data)->max_pages * PAGE_SIZE;
+}
+
+u32_t
+ramfs_rd_usage(struct v_superblock* vsb)
+{
+    return RAM_SB(vsb->data)->used_pages * PAGE_SIZE;
 }
 
 void
@@ -124,14 +200,35 @@ ramfs_inode_init(struct v_superblock* vsb, struct v_inode* inode)
 int
 ramfs_mount(struct v_superblock* vsb, struct v_dnode* mount_point)
 {
+    int errno;
+    struct ram_sb* rsb = valloc(sizeof(struct ram_sb));
+
+    if (!rsb) {
+        return ENOMEM;
+    }
+
+    rsb->max_pages = CONFIG_RAMFS_MAX_PAGES;
+    rsb->used_pages = 0;
+
+    vsb->data = rsb;
     vsb->ops.init_inode = ramfs_inode_init;
+    vsb->ops.read_capacity = ramfs_rd_capacity;
+    vsb->ops.read_usage = ramfs_rd_usage;
+
+    if ((errno = __ramfs_mknod(mount_point, NULL, RAMF_DIR))) {
+        vsb->data = NULL;
+        vfree(rsb);
+    }
 
-    return __ramfs_mknod(mount_point, NULL, RAMF_DIR);
+    return errno;
 }
 
 int
 ramfs_unmount(struct v_superblock* vsb)
 {
+    vfree(vsb->data);
+    vsb->data = NULL;
+
     return 0;
 }
 
@@ -197,9 +294,8 @@ ramfs_unlink(struct v_inode* this)
         return 0;
     }
 
-    // TODO
-
-    return 0;
+    // last and only link, give the space back right away
+    return ramfs_truncate(this, 0);
 }
 
 const struct v_inode_ops ramfs_inode_ops = { .mkdir = ramfs_mkdir,
@@ -207,17 +303,17 @@ const struct v_inode_ops ramfs_inode_ops = { .mkdir = ramfs_mkdir,
                                              .dir_lookup =
                                                default_inode_dirlookup,
                                              .create = ramfs_create,
-                                             .open = default_inode_open,
+                                             .open = ramfs_open,
                                              .unlink = ramfs_unlink,
                                              .set_symlink = ramfs_mksymlink,
                                              .read_symlink = ramfs_read_symlink,
                                              .rename = default_inode_rename };
 
-const struct v_file_ops ramfs_file_ops = { .readdir = ramfs_readdir,
+const struct v_file_ops ramfs_file_ops = { .readdir = default_file_readdir,
                                            .close = default_file_close,
-                                           .read = default_file_read,
-                                           .read_page = default_file_read_page,
-                                           .write = default_file_write,
-                                           .write_page =
-                                             default_file_write_page,
+                                           .read = ramfs_read,
+                                           .read_page = ramfs_read_page,
+                                           .write = ramfs_write,
+                                           .write_page = ramfs_write_page,
+                                           .truncate = ramfs_truncate,
                                            .seek = default_file_seek };
\ No newline at end of file
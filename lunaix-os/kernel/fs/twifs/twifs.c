@@ -248,7 +248,7 @@ twifs_init()
     struct filesystem* twifs = vzalloc(sizeof(struct filesystem));
     twifs->fs_name = HSTR("twifs", 5);
     twifs->mount = __twifs_mount;
-    twifs->types = FSTYPE_ROFS;
+    twifs->types = FSTYPE_ROFS | FSTYPE_PSEUDO;
     twifs->fs_id = 0;
 
     fsm_register(twifs);
@@ -64,7 +64,7 @@ static struct cake_pile* superblock_pile;
 static struct cake_pile* fd_pile;
 
 struct v_dnode* vfs_sysroot;
-static struct hbucket* dnode_cache;
+static struct rhash_table dnode_cache;
 
 struct lru_zone *dnode_lru, *inode_lru;
 
@@ -84,6 +84,12 @@ __vfs_try_evict_dnode(struct lru_node* obj);
 static int
 __vfs_try_evict_inode(struct lru_node* obj);
 
+static u32_t
+__vfs_dnode_key(struct lru_node* obj);
+
+static u32_t
+__dcache_entry_key(struct hlist_node* node);
+
 void
 vfs_init()
 {
@@ -95,10 +101,10 @@ vfs_init()
     superblock_pile =
       cake_new_pile("sb_cache", sizeof(struct v_superblock), 1, 0);
 
-    dnode_cache = vzalloc(VFS_HASHTABLE_SIZE * sizeof(struct hbucket));
+    rhash_init(&dnode_cache, VFS_DCACHE_ORDER, __dcache_entry_key);
 
-    dnode_lru = lru_new_zone(__vfs_try_evict_dnode);
-    inode_lru = lru_new_zone(__vfs_try_evict_inode);
+    dnode_lru = lru_new_zone_2q("dnode", __vfs_try_evict_dnode, __vfs_dnode_key);
+    inode_lru = lru_new_zone("inode", __vfs_try_evict_inode);
 
     hstr_rehash(&vfs_ddot, HSTR_FULL_HASH);
     hstr_rehash(&vfs_dot, HSTR_FULL_HASH);
@@ -109,52 +115,78 @@ vfs_init()
     atomic_fetch_add(&vfs_sysroot->ref_count, 1);
 }
 
-static inline struct hbucket*
-__dcache_hash(struct v_dnode* parent, u32_t* hash)
+static inline u32_t
+__dcache_key(struct v_dnode* parent, struct hstr* name)
+{
+    // same name under different parents are spread out
+    return name->hash ^ (u32_t)parent;
+}
+
+static u32_t
+__dcache_entry_key(struct hlist_node* node)
+{
+    struct v_dnode* dnode = container_of(node, struct v_dnode, hash_list);
+    return __dcache_key(dnode->parent, &dnode->name);
+}
+
+static inline bool
+__dcache_match(struct v_dnode* dnode,
+               struct v_dnode* parent,
+               struct hstr* name)
 {
-    u32_t _hash = *hash;
-    // 确保低位更加随机
-    _hash = _hash ^ (_hash >> VFS_HASHBITS);
-    // 与parent的指针值做加法，来减小碰撞的可能性。
-    _hash += (u32_t)parent;
-    *hash = _hash;
-    return &dnode_cache[_hash & VFS_HASH_MASK];
+    return dnode->parent == parent && hstreq(&dnode->name, name);
 }
 
 struct v_dnode*
 vfs_dcache_lookup(struct v_dnode* parent, struct hstr* str)
 {
-    if (!str->len || HSTR_EQ(str, &vfs_dot))
+    if (!str->len || hstreq(str, &vfs_dot))
         return parent;
 
-    if (HSTR_EQ(str, &vfs_ddot)) {
+    if (hstreq(str, &vfs_ddot)) {
         return parent->parent;
     }
 
-    u32_t hash = str->hash;
-    struct hbucket* slot = __dcache_hash(parent, &hash);
-
     struct v_dnode *pos, *n;
+    struct hbucket* slot =
+      rhash_bucket(&dnode_cache, __dcache_key(parent, str));
     hashtable_bucket_foreach(slot, pos, n, hash_list)
     {
-        if (pos->name.hash == hash) {
+        if (__dcache_match(pos, parent, str)) {
             return pos;
         }
     }
     return NULL;
 }
 
+static void
+__dcache_drop_negative(struct v_dnode* parent, struct hstr* name)
+{
+    struct v_dnode *pos, *n;
+    struct hbucket* slot =
+      rhash_bucket(&dnode_cache, __dcache_key(parent, name));
+    hashtable_bucket_foreach(slot, pos, n, hash_list)
+    {
+        if (__dcache_match(pos, parent, name) && vfs_d_negative(pos)) {
+            vfs_d_free(pos);
+        }
+    }
+}
+
 void
 vfs_dcache_add(struct v_dnode* parent, struct v_dnode* dnode)
 {
     assert(parent);
 
+    // the name is coming into existence
+    __dcache_drop_negative(parent, &dnode->name);
+
     atomic_fetch_add(&dnode->ref_count, 1);
     dnode->parent = parent;
     llist_append(&parent->children, &dnode->siblings);
 
-    struct hbucket* bucket = __dcache_hash(parent, &dnode->name.hash);
-    hlist_add(&bucket->head, &dnode->hash_list);
+    rhash_add(
+      &dnode_cache, &dnode->hash_list, __dcache_key(parent, &dnode->name));
 }
 
 void
@@ -163,14 +195,50 @@ vfs_dcache_remove(struct v_dnode* dnode)
     assert(dnode);
     assert(dnode->ref_count == 1);
 
+    if (dnode->parent) {
+        vfs_dcursor_evict(&dnode->parent->cursors, &dnode->siblings);
+    }
+
     llist_delete(&dnode->siblings);
     llist_delete(&dnode->aka_list);
-    hlist_delete(&dnode->hash_list);
+    rhash_remove(&dnode_cache, &dnode->hash_list);
 
     dnode->parent = NULL;
     atomic_fetch_sub(&dnode->ref_count, 1);
 }
 
+void
+vfs_dcache_prune_negative(struct v_dnode* dir)
+{
+    struct v_dnode *pos, *n;
+    llist_for_each(pos, n, &dir->children, siblings)
+    {
+        if (vfs_d_negative(pos) && pos->ref_count == 1) {
+            vfs_d_free(pos);
+        }
+    }
+}
+
+void
+vfs_dcursor_track(struct dir_cursor* cursor, struct llist_header* cursors)
+{
+    if (llist_empty(&cursor->trackers)) {
+        llist_append(cursors, &cursor->trackers);
+    }
+}
+
+void
+vfs_dcursor_evict(struct llist_header* cursors, struct llist_header* node)
+{
+    struct dir_cursor *pos, *n;
+    llist_for_each(pos, n, cursors, trackers)
+    {
+        if (pos->pos == node) {
+            pos->pos = node->prev;
+        }
+    }
+}
+
 void
 vfs_dcache_rehash(struct v_dnode* new_parent, struct v_dnode* dnode)
 {
@@ -181,15 +249,13 @@ vfs_dcache_rehash(struct v_dnode* new_parent, struct v_dnode* dnode)
     vfs_dcache_add(new_parent, dnode);
 }
 
-int
-vfs_open(struct v_dnode* dnode, struct v_file** file)
+static int
+__vfs_open(struct v_dnode* dnode, struct v_inode* inode, struct v_file** file)
 {
-    if (!dnode->inode || !dnode->inode->ops->open) {
+    if (!inode || !inode->ops->open) {
         return ENOTSUP;
     }
 
-    struct v_inode* inode = dnode->inode;
-
     lock_inode(inode);
 
     struct v_file* vfile = cake_grab(file_pile);
@@ -199,6 +265,7 @@ vfs_open(struct v_dnode* dnode, struct v_file** file)
     vfile->inode = inode;
     vfile->ref_count = ATOMIC_VAR_INIT(1);
     vfile->ops = inode->default_fops;
+    llist_init_head(&vfile->dcursor.trackers);
 
     if ((inode->itype & F_MFILE) && !inode->pg_cache) {
         struct pcache* pcache = vzalloc(sizeof(struct pcache));
@@ -223,6 +290,20 @@ vfs_open(struct v_dnode* dnode, struct v_file** file)
     return errno;
 }
 
+int
+vfs_open(struct v_dnode* dnode, struct v_file** file)
+{
+    return __vfs_open(dnode, dnode->inode, file);
+}
+
+int
+vfs_open_anon(struct v_dnode* dnode,
+              struct v_inode* inode,
+              struct v_file** file)
+{
+    return __vfs_open(dnode, inode, file);
+}
+
 void
 vfs_assign_inode(struct v_dnode* assign_to, struct v_inode* inode)
 {
@@ -290,6 +371,7 @@ vfs_pclose(struct v_file* file, pid_t pid)
         mnt_chillax(file->dnode->mnt);
 
         pcache_commit_all(file->inode);
+        llist_delete(&file->dcursor.trackers);
         cake_release(file_pile, file);
     }
     return errno;
@@ -341,20 +423,49 @@ vfs_alloc_fdslot(int* fd)
     return EMFILE;
 }
 
+int
+vfs_install_fd(struct v_file* file, int flags)
+{
+    int errno, fd;
+    struct v_fd* fd_s;
+
+    if ((errno = vfs_alloc_fdslot(&fd))) {
+        return errno;
+    }
+
+    if (!(fd_s = cake_grab(fd_pile))) {
+        return ENOMEM;
+    }
+
+    memset(fd_s, 0, sizeof(*fd_s));
+    fd_s->file = file;
+    fd_s->flags = flags;
+    __current->fdtable->fds[fd] = fd_s;
+
+    return fd;
+}
+
+static u32_t
+__icache_entry_key(struct hlist_node* node)
+{
+    return container_of(node, struct v_inode, hash_list)->id;
+}
+
 struct v_superblock*
 vfs_sb_alloc()
 {
     struct v_superblock* sb = cake_grab(superblock_pile);
     memset(sb, 0, sizeof(*sb));
     llist_init_head(&sb->sb_list);
-    sb->i_cache = vzalloc(VFS_HASHTABLE_SIZE * sizeof(struct hbucket));
+    rhash_init(&sb->i_cache, VFS_ICACHE_ORDER, __icache_entry_key);
     return sb;
 }
 
 void
 vfs_sb_free(struct v_superblock* sb)
 {
-    vfree(sb->i_cache);
+    // inodes left are recycled by lru eventually
+    rhash_release(&sb->i_cache);
     cake_release(superblock_pile, sb);
 }
 
@@ -367,9 +478,23 @@ __vfs_try_evict_dnode(struct lru_node* obj)
         vfs_d_free(dnode);
         return 1;
     }
+
+    // negative entry only referenced by dcache
+    if (vfs_d_negative(dnode) && dnode->parent && dnode->ref_count == 1) {
+        vfs_d_free(dnode);
+        return 1;
+    }
     return 0;
 }
 
+static u32_t
+__vfs_dnode_key(struct lru_node* obj)
+{
+    struct v_dnode* dnode = container_of(obj, struct v_dnode, lru);
+
+    return dnode->name.hash ^ (u32_t)dnode->super_block;
+}
+
 static int
 __vfs_try_evict_inode(struct lru_node* obj)
 {
@@ -398,6 +523,7 @@ vfs_d_alloc(struct v_dnode* parent, struct hstr* name)
     llist_init_head(&dnode->children);
     llist_init_head(&dnode->siblings);
     llist_init_head(&dnode->aka_list);
+    llist_init_head(&dnode->cursors);
     mutex_init(&dnode->lock);
 
     dnode->ref_count = ATOMIC_VAR_INIT(0);
@@ -425,7 +551,11 @@ vfs_d_free(struct v_dnode* dnode)
         dnode->inode->link_count--;
     }
 
+    lru_remove(dnode_lru, &dnode->lru);
     vfs_dcache_remove(dnode);
+    // negative ones are meaningless without parent
+    vfs_dcache_prune_negative(dnode);
+
     // Make sure the children de-referencing their parent.
     // With lru presented, the eviction will be propagated over the entire
     // detached subtree eventually
@@ -442,7 +572,7 @@ vfs_d_free(struct v_dnode* dnode)
 struct v_inode*
 vfs_i_find(struct v_superblock* sb, u32_t i_id)
 {
-    struct hbucket* slot = &sb->i_cache[i_id & VFS_HASH_MASK];
+    struct hbucket* slot = rhash_bucket(&sb->i_cache, i_id);
     struct v_inode *pos, *n;
     hashtable_bucket_foreach(slot, pos, n, hash_list)
     {
@@ -458,10 +588,10 @@ vfs_i_find(struct v_superblock* sb, u32_t i_id)
 void
 vfs_i_addhash(struct v_inode* inode)
 {
-    struct hbucket* slot = &inode->sb->i_cache[inode->id & VFS_HASH_MASK];
+    struct rhash_table* icache = &inode->sb->i_cache;
 
-    hlist_delete(&inode->hash_list);
-    hlist_add(&slot->head, &inode->hash_list);
+    rhash_remove(icache, &inode->hash_list);
+    rhash_add(icache, &inode->hash_list, inode->id);
 }
 
 struct v_inode*
@@ -496,6 +626,8 @@ vfs_i_alloc(struct v_superblock* sb)
 void
 vfs_i_free(struct v_inode* inode)
 {
+    lru_remove(inode_lru, &inode->lru);
+
     if (inode->pg_cache) {
         pcache_release(inode->pg_cache);
         vfree(inode->pg_cache);
@@ -506,7 +638,7 @@ vfs_i_free(struct v_inode* inode)
     if (inode->destruct) {
         inode->destruct(inode);
     }
-    hlist_delete(&inode->hash_list);
+    rhash_remove(&inode->sb->i_cache, &inode->hash_list);
     cake_release(inode_pile, inode);
 }
 
@@ -647,6 +779,33 @@ __vfs_readdir_callback(struct dir_context* dctx,
     dent->d_type = dtype;
 }
 
+/**
+ * @brief Read the directory entry at `offset`, counting in "." and "..".
+ *
+ * @return int 1 if read, 0 at the end, or error.
+ */
+static int
+__vfs_readdir_at(struct v_file* file, struct lx_dirent* dent, u32_t offset)
+{
+    struct dir_context dctx = (struct dir_context){
+      .cb_data = dent,
+      .index = offset,
+      .read_complete_callback = __vfs_readdir_callback };
+
+    if (offset == 0) {
+        __vfs_readdir_callback(&dctx, vfs_dot.value, vfs_dot.len, DT_DIR);
+        return 1;
+    }
+
+    if (offset == 1) {
+        __vfs_readdir_callback(&dctx, vfs_ddot.value, vfs_ddot.len, DT_DIR);
+        return 1;
+    }
+
+    dctx.index -= 2;
+    return file->ops->readdir(file, &dctx);
+}
+
 __DEFINE_LXSYSCALL2(int, sys_readdir, int, fd, struct lx_dirent*, dent)
 {
     struct v_fd* fd_s;
@@ -662,23 +821,8 @@ __DEFINE_LXSYSCALL2(int, sys_readdir, int, fd, struct lx_dirent*, dent)
 
     if ((inode->itype & F_FILE)) {
         errno = ENOTDIR;
-    } else {
-        struct dir_context dctx = (struct dir_context){
-          .cb_data = dent,
-          .index = dent->d_offset,
-          .read_complete_callback = __vfs_readdir_callback};
-        errno = 1;
-        if (dent->d_offset == 0) {
-            __vfs_readdir_callback(&dctx, vfs_dot.value, vfs_dot.len, DT_DIR);
-        } else if (dent->d_offset == 1) {
-            __vfs_readdir_callback(&dctx, vfs_ddot.value, vfs_ddot.len, DT_DIR);
-        } else {
-            dctx.index -= 2;
-            if ((errno = fd_s->file->ops->readdir(fd_s->file, &dctx)) != 1) {
-                unlock_inode(inode);
-                goto done;
-            }
-        }
+    } else if ((errno = __vfs_readdir_at(fd_s->file, dent, dent->d_offset)) ==
+               1) {
         dent->d_offset++;
     }
 
@@ -688,6 +832,69 @@ done:
     return DO_STATUS_OR_RETURN(errno);
 }
 
+__DEFINE_LXSYSCALL3(int,
+                    sys_getdents,
+                    int,
+                    fd,
+                    struct lx_dirent*,
+                    dents,
+                    unsigned int,
+                    count)
+{
+    struct v_fd* fd_s;
+    struct v_file* file;
+    unsigned int i = 0;
+    int errno;
+
+    if ((errno = vfs_getfd(fd, &fd_s))) {
+        goto done;
+    }
+
+    file = fd_s->file;
+
+    lock_inode(file->inode);
+
+    if ((file->inode->itype & F_FILE)) {
+        errno = ENOTDIR;
+        goto unlock;
+    }
+
+    // position of a directory is the offset of next entry
+    for (; i < count; i++) {
+        if ((errno = __vfs_readdir_at(file, &dents[i], file->f_pos)) != 1) {
+            break;
+        }
+        dents[i].d_offset = ++file->f_pos;
+    }
+
+    if (i) {
+        errno = i;
+    }
+
+unlock:
+    unlock_inode(file->inode);
+
+done:
+    return DO_STATUS_OR_RETURN(errno);
+}
+
+/**
+ * @brief Whether the file content is produced or consumed on the fly rather
+ *        than stored, such file is accessed directly, never through page
+ *        cache.
+ */
+static inline bool
+__vfs_direct_only(struct v_inode* inode)
+{
+    u32_t itype = inode->itype;
+
+    if ((itype & F_PIPE) || (itype & F_SEQDEV) == F_SEQDEV) {
+        return true;
+    }
+
+    return !!(inode->sb->fs->types & FSTYPE_PSEUDO);
+}
+
 __DEFINE_LXSYSCALL3(int, read, int, fd, void*, buf, size_t, count)
 {
     int errno = 0;
@@ -706,10 +913,11 @@ __DEFINE_LXSYSCALL3(int, read, int, fd, void*, buf, size_t, count)
 
     file->inode->atime = clock_unixtime();
 
-    if ((file->inode->itype & VFS_IFSEQDEV) || (fd_s->flags & FO_DIRECT)) {
+    if (__vfs_direct_only(file->inode) || (fd_s->flags & FO_DIRECT)) {
         errno = file->ops->read(file->inode, buf, count, file->f_pos);
     } else {
-        errno = pcache_read(file->inode, buf, count, file->f_pos);
+        errno = pcache_read(
+          file->inode, &file->ra, buf, count, file->f_pos);
     }
 
     if (errno > 0) {
@@ -747,7 +955,7 @@ __DEFINE_LXSYSCALL3(int, write, int, fd, void*, buf, size_t, count)
 
     file->inode->mtime = clock_unixtime();
 
-    if ((file->inode->itype & VFS_IFSEQDEV) || (fd_s->flags & FO_DIRECT)) {
+    if (__vfs_direct_only(file->inode) || (fd_s->flags & FO_DIRECT)) {
         errno = file->ops->write(file->inode, buf, count, file->f_pos);
     } else {
         errno = pcache_write(file->inode, buf, count, file->f_pos);
@@ -861,6 +1069,8 @@ vfs_get_dtype(int itype)
 {
     if ((itype & VFS_IFSYMLINK) == VFS_IFSYMLINK) {
         return DT_SYMLINK;
+    } else if ((itype & VFS_IFPIPE) == VFS_IFPIPE) {
+        return DT_PIPE;
     } else if (!(itype & VFS_IFFILE)) {
         return DT_DIR;
     } else {
@@ -959,6 +1169,7 @@ __DEFINE_LXSYSCALL1(int, rmdir, const char*, pathname)
         goto done;
     }
 
+    vfs_dcache_prune_negative(dnode);
     if (!llist_empty(&dnode->children)) {
         errno = ENOTEMPTY;
         goto done;
@@ -1130,6 +1341,48 @@ __DEFINE_LXSYSCALL1(int, fsync, int, fildes)
     return DO_STATUS(errno);
 }
 
+__DEFINE_LXSYSCALL2(int, ftruncate, int, fd, int, length)
+{
+    int errno;
+    struct v_fd* fd_s;
+
+    if ((errno = vfs_getfd(fd, &fd_s))) {
+        goto done;
+    }
+
+    struct v_file* file = fd_s->file;
+
+    if (!(file->inode->itype & F_FILE)) {
+        errno = EISDIR;
+        goto done;
+    }
+
+    if ((errno = vfs_check_writable(file->dnode))) {
+        goto done;
+    }
+
+    if (length < 0) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    if (!file->ops->truncate) {
+        errno = ENOTSUP;
+        goto done;
+    }
+
+    lock_inode(file->inode);
+
+    if (!(errno = file->ops->truncate(file->inode, length))) {
+        file->inode->mtime = clock_unixtime();
+    }
+
+    unlock_inode(file->inode);
+
+done:
+    return DO_STATUS(errno);
+}
+
 int
 vfs_dup_fd(struct v_fd* old, struct v_fd** new)
 {
@@ -1344,7 +1597,7 @@ int
 vfs_do_rename(struct v_dnode* current, struct v_dnode* target)
 {
     int errno = 0;
-    if (current->inode->id == target->inode->id) {
+    if (target->inode && current->inode->id == target->inode->id) {
         // hard link
         return 0;
     }
@@ -1371,6 +1624,7 @@ vfs_do_rename(struct v_dnode* current, struct v_dnode* target)
     if (newparent)
         lock_dnode(newparent);
 
+    vfs_dcache_prune_negative(target);
     if (!llist_empty(&target->children)) {
         errno = ENOTEMPTY;
         unlock_dnode(target);
@@ -1383,14 +1637,13 @@ vfs_do_rename(struct v_dnode* current, struct v_dnode* target)
         goto cleanup;
     }
 
-    // re-position current
+    // detach target, before current takes over its name
     hstrcpy(&current->name, &target->name);
-    vfs_dcache_rehash(newparent, current);
-
-    // detach target
+    unlock_dnode(target);
     vfs_d_free(target);
 
-    unlock_dnode(target);
+    // re-position current
+    vfs_dcache_rehash(newparent, current);
 
 cleanup:
     unlock_dnode(current);
@@ -1419,19 +1672,21 @@ __DEFINE_LXSYSCALL2(int, rename, const char*, oldpath, const char*, newpath)
 
     errno = vfs_walk(target_parent, name.value, &target, NULL, 0);
     if (errno == ENOENT) {
-        target = vfs_d_alloc(target_parent, &name);
+        if (!(target = vfs_d_alloc(target_parent, &name))) {
+            errno = ENOMEM;
+            goto done;
+        }
         vfs_dcache_add(target_parent, target);
     } else if (errno) {
         goto done;
     }
 
-    if (!target) {
-        errno = ENOMEM;
-        goto done;
-    }
-
     errno = vfs_do_rename(cur, target);
 
+    if (errno && vfs_d_negative(target)) {
+        vfs_d_free(target);
+    }
+
 done:
     vfree((void*)name.value);
     return DO_STATUS(errno);
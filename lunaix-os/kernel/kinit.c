@@ -117,6 +117,9 @@ spawn_lunad()
     has_error = spawn_process(&kthread, (ptr_t)lunad_main, false);
     assert_msg(!has_error, "failed to spawn lunad");
 
+    // lunad is always runnable, it should not get in others' way.
+    kthread->process->nice = SCHED_NICE_MAX;
+
     run(kthread);
     
     fail("Unexpected Return");
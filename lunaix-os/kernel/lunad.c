@@ -10,6 +10,7 @@
 #include <lunaix/owloysius.h>
 #include <lunaix/sched.h>
 #include <lunaix/kpreempt.h>
+#include <lunaix/timer.h>
 
 #include <klibc/string.h>
 
@@ -75,6 +76,7 @@ void _preemptible
 lunad_main()
 {
     spawn_kthread((ptr_t)init_platform);
+    spawn_kthread((ptr_t)pcache_writeback_main);
 
     /*
         NOTE Kernel preemption after this point.
@@ -91,6 +93,10 @@ lunad_main()
     while (1)
     {
         cleanup_detached_threads();
+
+        // doze till something happen, if nobody else want the cpu.
+        timer_idle();
+
         sched_pass();
     }
 }
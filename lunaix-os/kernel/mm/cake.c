@@ -16,29 +16,77 @@
 #include <lunaix/spike.h>
 #include <lunaix/syslog.h>
 
+#include <sys/cpu.h>
+#include <sys/mm/mempart.h>
+
 LOG_MODULE("CAKE")
 
 #define CACHE_LINE_SIZE 128
 
 struct cake_pile master_pile;
 
+static struct cake_pile* mag_pile;
+
 struct llist_header piles = { .next = &piles, .prev = &piles };
 
-void*
-__alloc_cake(unsigned int cake_pg)
+struct cake_s*
+__alloc_cake(struct cake_pile* pile)
 {
-    struct leaflet* leaflet = alloc_leaflet(count_order(cake_pg));
+    struct leaflet* leaflet;
+    struct cake_s* cake;
+    struct ppage* lead;
+
+    leaflet = alloc_leaflet(count_order(pile->pg_per_cake));
     if (!leaflet) {
         return NULL;
     }
     
-    return (void*)vmap(leaflet, KERNEL_DATA);
+    cake = (struct cake_s*)vmap(leaflet, KERNEL_DATA);
+
+    // back-pointers, so a piece can find its way home in O(1)
+    lead = get_ppage(leaflet);
+    lead->cake.pile = pile;
+    lead->cake.cake = cake;
+
+    return cake;
+}
+
+/**
+ * @brief Locate the lead page of the cake that contains the given address.
+ *        Pages not belonging to any cake are rejected by checking that the
+ *        back-pointer actually points to the head of its own leaflet.
+ */
+static struct ppage*
+__cake_page(void* area)
+{
+    ptr_t va = (ptr_t)area;
+    struct ppage *page, *lead;
+    pte_t pte;
+
+    if (va < VMAP || va >= VMAP_END) {
+        return NULL;
+    }
+
+    pte = pte_at(mkptep_va(VMS_SELF, va));
+    if (!pte_isloaded(pte)) {
+        return NULL;
+    }
+
+    page = ppage(pfn(pte_paddr(pte)));
+    lead = leading_page(page);
+
+    va = page_aligned(va) - page_addr(page->companion);
+    if ((ptr_t)lead->cake.cake != va) {
+        return NULL;
+    }
+
+    return lead;
 }
 
 struct cake_s*
 __new_cake(struct cake_pile* pile)
 {
-    struct cake_s* cake = __alloc_cake(pile->pg_per_cake);
+    struct cake_s* cake = __alloc_cake(pile);
 
     if (!cake) {
         return NULL;
@@ -88,7 +136,8 @@ __init_pile(struct cake_pile* pile,
                                 .pieces_per_cake =
                                   (pg_per_cake * PAGE_SIZE) /
                                   (piece_size + sizeof(piece_index_t)),
-                                .pg_per_cake = pg_per_cake };
+                                .pg_per_cake = pg_per_cake,
+                                .options = options };
 
     unsigned int free_list_size = pile->pieces_per_cake * sizeof(piece_index_t);
 
@@ -100,13 +149,19 @@ __init_pile(struct cake_pile* pile,
     llist_init_head(&pile->free);
     llist_init_head(&pile->full);
     llist_init_head(&pile->partial);
+    llist_init_head(&pile->depot.full);
+    llist_init_head(&pile->depot.empty);
     llist_append(&piles, &pile->piles);
 }
 
 void
 cake_init()
 {
-    __init_pile(&master_pile, "pinkamina", sizeof(master_pile), 1, 0);
+    __init_pile(
+      &master_pile, "pinkamina", sizeof(master_pile), 1, PILE_NO_MAGAZINE);
+
+    mag_pile = cake_new_pile(
+      "cake_mag", sizeof(struct cake_mag), 1, PILE_NO_MAGAZINE);
 }
 
 struct cake_pile*
@@ -131,8 +186,8 @@ cake_set_constructor(struct cake_pile* pile, pile_cb ctor)
     pile->ctor = ctor;
 }
 
-void*
-cake_grab(struct cake_pile* pile)
+static void*
+__slab_grab(struct cake_pile* pile)
 {
     struct cake_s *pos, *n;
     if (!llist_empty(&pile->partial)) {
@@ -149,7 +204,6 @@ cake_grab(struct cake_pile* pile)
     piece_index_t found_index = pos->next_free;
     pos->next_free = pos->free_list[found_index];
     pos->used_pieces++;
-    pile->alloced_pieces++;
 
     llist_delete(&pos->cakes);
     if (pos->free_list[pos->next_free] == EO_FREE_PIECE) {
@@ -158,49 +212,47 @@ cake_grab(struct cake_pile* pile)
         llist_append(&pile->partial, &pos->cakes);
     }
 
-    void* ptr =
-      (void*)((ptr_t)pos->first_piece + found_index * pile->piece_size);
-
-    if (pile->ctor) {
-        pile->ctor(pile, ptr);
-    }
-
-    return ptr;
+    return (void*)((ptr_t)pos->first_piece + found_index * pile->piece_size);
 }
 
-int
-cake_release(struct cake_pile* pile, void* area)
+static struct cake_s*
+__slab_locate(struct cake_pile* pile, void* area, piece_index_t* index)
 {
-    piece_index_t piece_index;
-    size_t dsize = 0;
-    struct cake_s *pos, *n;
-    struct llist_header* hdrs[2] = { &pile->full, &pile->partial };
-
-    for (size_t i = 0; i < 2; i++) {
-        llist_for_each(pos, n, hdrs[i], cakes)
-        {
-            if (pos->first_piece > area) {
-                continue;
-            }
-            dsize = (ptr_t)(area - pos->first_piece);
-            piece_index = dsize / pile->piece_size;
-            if (piece_index < pile->pieces_per_cake) {
-                goto found;
-            }
-        }
+    size_t dsize;
+    struct cake_s* pos;
+    struct ppage* lead;
+
+    lead = __cake_page(area);
+    if (!lead || lead->cake.pile != pile) {
+        return NULL;
+    }
+
+    pos = lead->cake.cake;
+    if (pos->first_piece > area) {
+        return NULL;
     }
 
-    return 0;
+    dsize = (ptr_t)(area - pos->first_piece);
+    *index = dsize / pile->piece_size;
+    if (*index >= pile->pieces_per_cake) {
+        return NULL;
+    }
 
-found:
     assert(!(dsize % pile->piece_size));
+    return pos;
+}
+
+static void
+__slab_release(struct cake_pile* pile,
+               struct cake_s* pos,
+               piece_index_t piece_index)
+{
     pos->free_list[piece_index] = pos->next_free;
     pos->next_free = piece_index;
 
     assert_msg(pos->free_list[piece_index] != pos->next_free, "double free");
 
     pos->used_pieces--;
-    pile->alloced_pieces--;
 
     llist_delete(&pos->cakes);
     if (!pos->used_pieces) {
@@ -208,9 +260,281 @@ found:
     } else {
         llist_append(&pile->partial, &pos->cakes);
     }
+}
+
+/*
+    Magazine layer, following Bonwick's design. Every cpu keeps a pair
+    of magazines (loaded, previous) in front of the pile, and
+    exchanges them against the depot only when both run dry (or full).
+    Pieces parked in magazines stay allocated from cake's point of
+    view, so the slab metadata is not touched on the fast path.
+
+    The per-cpu pair is only ever accessed with local interrupt
+    disabled. The depot is the only state shared across cpus, which
+    is fine as long as Lunaix stays uniprocessor.
+
+    TODO lock the depot once we go SMP
+*/
+
+#define __cpu_cache(pile) (&(pile)->cpu_caches[cpu_id()])
+
+#define MAG_ROUNDS CONFIG_CAKE_MAG_ROUNDS
+
+static inline bool
+__mag_full(struct cake_mag* mag)
+{
+    return mag && mag->rounds == MAG_ROUNDS;
+}
+
+static inline bool
+__mag_empty(struct cake_mag* mag)
+{
+    return !mag || !mag->rounds;
+}
+
+static bool
+__mag_holds(struct cake_mag* mag, void* area)
+{
+    if (!mag) {
+        return false;
+    }
 
+    for (unsigned int i = 0; i < mag->rounds; i++) {
+        if (mag->pieces[i] == area) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool
+__depot_holds(struct cake_depot* depot, void* area)
+{
+    struct cake_mag *pos, *n;
+
+    llist_for_each(pos, n, &depot->full, mags)
+    {
+        if (__mag_holds(pos, area)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct cake_mag*
+__depot_take(struct llist_header* list, unsigned int* count)
+{
+    struct cake_mag* mag;
+
+    if (llist_empty(list)) {
+        return NULL;
+    }
+
+    mag = list_entry(list->next, struct cake_mag, mags);
+    llist_delete(&mag->mags);
+    (*count)--;
+
+    return mag;
+}
+
+static void
+__depot_put(struct cake_pile* pile, struct cake_mag* mag)
+{
+    struct cake_depot* depot = &pile->depot;
+    piece_index_t index;
+    struct cake_s* cake;
+
+    if (!mag) {
+        return;
+    }
+
+    if (!mag->rounds) {
+        llist_append(&depot->empty, &mag->mags);
+        depot->nr_empty++;
+        return;
+    }
+
+    if (depot->nr_full < CONFIG_CAKE_DEPOT_MAXMAG) {
+        llist_append(&depot->full, &mag->mags);
+        depot->nr_full++;
+        return;
+    }
+
+    // depot is saturated, give the pieces back to their cakes
+    while (mag->rounds) {
+        void* area = mag->pieces[--mag->rounds];
+        cake = __slab_locate(pile, area, &index);
+        __slab_release(pile, cake, index);
+    }
+
+    llist_append(&depot->empty, &mag->mags);
+    depot->nr_empty++;
+}
+
+static struct cake_mag*
+__mag_new(struct cake_pile* pile)
+{
+    struct cake_depot* depot = &pile->depot;
+    struct cake_mag* mag;
+
+    mag = __depot_take(&depot->empty, &depot->nr_empty);
+    if (mag || !mag_pile) {
+        return mag;
+    }
+
+    mag = (struct cake_mag*)cake_grab(mag_pile);
+    if (mag) {
+        mag->rounds = 0;
+        llist_init_head(&mag->mags);
+    }
+
+    return mag;
+}
+
+static void*
+__mag_grab(struct cake_pile* pile)
+{
+    struct cake_cpu_cache* cc = __cpu_cache(pile);
+    struct cake_depot* depot = &pile->depot;
+    struct cake_mag* mag;
+
+    if (!__mag_empty(cc->loaded)) {
+        goto done;
+    }
+
+    if (!__mag_empty(cc->previous)) {
+        mag = cc->previous;
+        cc->previous = cc->loaded;
+        cc->loaded = mag;
+        goto done;
+    }
+
+    mag = __depot_take(&depot->full, &depot->nr_full);
+    if (!mag) {
+        return NULL;
+    }
+
+    __depot_put(pile, cc->previous);
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+
+done:
+    mag = cc->loaded;
+    return mag->pieces[--mag->rounds];
+}
+
+static bool
+__mag_release(struct cake_pile* pile, void* area)
+{
+    struct cake_cpu_cache* cc = __cpu_cache(pile);
+    struct cake_mag* mag;
+
+    // only a poisoned piece can be a double free, avoid the scan otherwise
+    if (*(unsigned int*)area == DEADCAKE_MARK) {
+        assert_msg(!__mag_holds(cc->loaded, area) &&
+                     !__mag_holds(cc->previous, area) &&
+                     !__depot_holds(&pile->depot, area),
+                   "double free");
+    }
+
+    if (cc->loaded && !__mag_full(cc->loaded)) {
+        goto done;
+    }
+
+    if (cc->previous && !__mag_full(cc->previous)) {
+        mag = cc->previous;
+        cc->previous = cc->loaded;
+        cc->loaded = mag;
+        goto done;
+    }
+
+    mag = __mag_new(pile);
+    if (!mag) {
+        return false;
+    }
+
+    __depot_put(pile, cc->previous);
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+
+done:
+    mag = cc->loaded;
+    mag->pieces[mag->rounds++] = area;
+    return true;
+}
+
+void*
+cake_grab(struct cake_pile* pile)
+{
+    void* ptr = NULL;
+    u32_t intr = cpu_save_interrupt();
+
+    if (!(pile->options & PILE_NO_MAGAZINE)) {
+        if ((ptr = __mag_grab(pile))) {
+            pile->grab_hits++;
+        } else {
+            pile->grab_misses++;
+        }
+    }
+
+    if (!ptr) {
+        ptr = __slab_grab(pile);
+    }
+
+    if (ptr) {
+        pile->alloced_pieces++;
+    }
+
+    cpu_restore_interrupt(intr);
+
+    if (ptr && pile->ctor) {
+        pile->ctor(pile, ptr);
+    }
+
+    return ptr;
+}
+
+struct cake_pile*
+cake_pile_of(void* area)
+{
+    struct ppage* lead = __cake_page(area);
+    if (!lead) {
+        return NULL;
+    }
+
+    return lead->cake.pile;
+}
+
+int
+cake_release(struct cake_pile* pile, void* area)
+{
+    piece_index_t piece_index;
+    struct cake_s* pos;
+    u32_t intr;
+
+    pos = __slab_locate(pile, area, &piece_index);
+    if (!pos) {
+        return 0;
+    }
+
+    intr = cpu_save_interrupt();
+
+    if (pile->options & PILE_NO_MAGAZINE) {
+        __slab_release(pile, pos, piece_index);
+    } else if (__mag_release(pile, area)) {
+        pile->release_hits++;
+    } else {
+        pile->release_misses++;
+        __slab_release(pile, pos, piece_index);
+    }
+
+    pile->alloced_pieces--;
     *((unsigned int*)area) = DEADCAKE_MARK;
 
+    cpu_restore_interrupt(intr);
+
     return 1;
 }
 
@@ -25,12 +25,16 @@ __cake_rd_stat(struct twimap* map)
 {
     struct cake_pile* pos = twimap_index(map, struct cake_pile*);
     twimap_printf(map,
-                  "%s %d %d %d %d\n",
+                  "%s %d %d %d %d %u %u %u %u\n",
                   pos->pile_name,
                   pos->cakes_count,
                   pos->pg_per_cake,
                   pos->pieces_per_cake,
-                  pos->alloced_pieces);
+                  pos->alloced_pieces,
+                  pos->grab_hits,
+                  pos->grab_misses,
+                  pos->release_hits,
+                  pos->release_misses);
 }
 
 void
@@ -68,6 +72,28 @@ __cake_rd_ppg(struct twimap* map)
     twimap_printf(map, "%u", pile->pg_per_cake);
 }
 
+void
+__cake_rd_grab_hit(struct twimap* map)
+{
+    struct cake_pile* pile = twimap_data(map, struct cake_pile*);
+    twimap_printf(map, "%u %u", pile->grab_hits, pile->grab_misses);
+}
+
+void
+__cake_rd_release_hit(struct twimap* map)
+{
+    struct cake_pile* pile = twimap_data(map, struct cake_pile*);
+    twimap_printf(map, "%u %u", pile->release_hits, pile->release_misses);
+}
+
+void
+__cake_rd_depot(struct twimap* map)
+{
+    struct cake_pile* pile = twimap_data(map, struct cake_pile*);
+    twimap_printf(
+      map, "%u %u", pile->depot.nr_full, pile->depot.nr_empty);
+}
+
 void
 cake_export_pile(struct twifs_node* root, struct cake_pile* pile)
 {
@@ -87,6 +113,15 @@ cake_export_pile(struct twifs_node* root, struct cake_pile* pile)
 
     map = twifs_mapping(pile_rt, pile, "page_per_cake");
     map->read = __cake_rd_ppg;
+
+    map = twifs_mapping(pile_rt, pile, "mag_grab");
+    map->read = __cake_rd_grab_hit;
+
+    map = twifs_mapping(pile_rt, pile, "mag_release");
+    map->read = __cake_rd_release_hit;
+
+    map = twifs_mapping(pile_rt, pile, "mag_depot");
+    map->read = __cake_rd_depot;
 }
 
 void
@@ -1,3 +1,4 @@
+#include <lunaix/fs.h>
 #include <lunaix/mm/fault.h>
 #include <lunaix/mm/pmm.h>
 #include <lunaix/mm/region.h>
@@ -16,6 +17,9 @@
 
 LOG_MODULE("pf")
 
+// pages around a file-backed fault to be mapped if cached, power of 2
+#define FAULT_AROUND_PAGES 16
+
 static void
 __gather_memaccess_info(struct fault_context* context)
 {
@@ -119,6 +123,33 @@ __flush_staled_tlb(struct fault_context* fault, struct leaflet* leaflet)
     tlb_flush_mm_range(fault->mm, fault->fault_va, leaflet_nfold(leaflet));
 }
 
+static void
+__handle_shared_write(struct fault_context* fault)
+{
+    struct mm_region* vmr = fault->vmr;
+    struct v_inode* inode;
+    struct pcache_pg* pg;
+    pte_t pte = fault->fault_pte;
+
+    if (!(vmr->attr & REGION_WRITE)) {
+        return;
+    }
+
+    // first write to a page cache page since mapped, from now on
+    //  the pte dirty bit is all we got, picked up by msync.
+    if (vmr->mfile && (inode = vmr->mfile->inode)->pg_cache) {
+        u32_t fpos = page_aligned(fault->fault_va) - vmr->start + vmr->foff;
+        if ((pg = pcache_lookup(inode->pg_cache, fpos))) {
+            pcache_set_dirty(inode->pg_cache, pg);
+        }
+    }
+
+    set_pte(fault->fault_ptep, pte_mkwritable(pte));
+    __flush_staled_tlb(fault, pte_leaflet(pte));
+
+    fault_resolved(fault, NO_PREALLOC);
+}
+
 static void
 __handle_conflict_pte(struct fault_context* fault) 
 {
@@ -134,6 +165,11 @@ __handle_conflict_pte(struct fault_context* fault)
 
     assert(pte_iswprotect(pte));
 
+    if (shared_writable_region(fault->vmr)) {
+        __handle_shared_write(fault);
+        return;
+    }
+
     if (writable_region(fault->vmr)) {
         // normal page fault, do COW
         duped_leaflet = dup_leaflet(fault_leaflet);
@@ -172,24 +208,17 @@ __handle_anon_region(struct fault_context* fault)
 
 
 static void
-__handle_named_region(struct fault_context* fault)
+__handle_uncached_region(struct fault_context* fault, pte_t pte, u32_t foff)
 {
-    struct mm_region* vmr = fault->vmr;
-    struct v_file* file = vmr->mfile;
-
-    pte_t pte       = fault->resolving;
+    struct v_file* file = fault->vmr->mfile;
     ptr_t fault_va  = page_aligned(fault->fault_va);
 
-    u32_t mseg_off  = (fault_va - vmr->start);
-    u32_t mfile_off = mseg_off + vmr->foff;
-
     // TODO Potentially we can get different order of leaflet here
     struct leaflet* region_part = alloc_leaflet(0);
 
-    pte = pte_setprot(pte, region_pteprot(vmr));
     ptep_map_leaflet(fault->fault_ptep, pte, region_part);
 
-    int errno = file->ops->read_page(file->inode, (void*)fault_va, mfile_off);
+    int errno = file->ops->read_page(file->inode, (void*)fault_va, foff);
     if (errno < 0) {
         ERROR("fail to populate page (%d)", errno);
 
@@ -204,6 +233,92 @@ __handle_named_region(struct fault_context* fault)
     fault_resolved(fault, NO_PREALLOC);
 }
 
+/**
+ * @brief Map the cached pages near the faulting one within an aligned
+ * window, as file regions are usually accessed sequentially.
+ */
+static void
+__fault_around(struct fault_context* fault, pte_t pte)
+{
+    struct mm_region* vmr = fault->vmr;
+    struct v_inode* inode = vmr->mfile->inode;
+    struct leaflet* leaflet;
+    pte_t* ptep;
+    ptr_t va, start, end;
+    ptr_t fault_va = page_aligned(fault->fault_va);
+
+    if (fault->ptep_fault) {
+        return;
+    }
+
+    // aligned window never cross the boundary of page table
+    start = ROUNDDOWN(fault_va, FAULT_AROUND_PAGES * PAGE_SIZE);
+    end   = start + FAULT_AROUND_PAGES * PAGE_SIZE;
+    start = MAX(start, vmr->start);
+    end   = MIN(end, vmr->end);
+
+    ptep = fault->fault_ptep - pfn(fault_va - start);
+    for (va = start; va < end; va += PAGE_SIZE, ptep++) {
+        if (va == fault_va || !pte_isnull(pte_at(ptep))) {
+            continue;
+        }
+
+        if (!pcache_map_cached(inode, va - vmr->start + vmr->foff, &leaflet)) {
+            continue;
+        }
+
+        ptep_map_leaflet(ptep, pte, leaflet);
+        fault->mm->stats.mapped_around++;
+    }
+
+    tlb_flush_mm_range(fault->mm, start, pfn(end - start));
+
+    // get those not yet cached ready for the next fault
+    if (fault_va + PAGE_SIZE < end) {
+        pcache_prefetch(inode,
+                        fault_va + PAGE_SIZE - vmr->start + vmr->foff,
+                        end - vmr->start + vmr->foff);
+    }
+}
+
+static void
+__handle_named_region(struct fault_context* fault)
+{
+    struct mm_region* vmr = fault->vmr;
+    struct v_inode* inode = vmr->mfile->inode;
+    struct leaflet* region_part;
+
+    pte_t pte       = fault->resolving;
+    ptr_t fault_va  = page_aligned(fault->fault_va);
+
+    u32_t mseg_off  = (fault_va - vmr->start);
+    u32_t mfile_off = mseg_off + vmr->foff;
+
+    pte = pte_setprot(pte, region_pteprot(vmr));
+
+    if (!inode->pg_cache) {
+        __handle_uncached_region(fault, pte, mfile_off);
+        return;
+    }
+
+    int errno = pcache_map_page(inode, mfile_off, &region_part);
+    if (errno < 0) {
+        ERROR("fail to populate page (%d)", errno);
+        return;
+    }
+
+    // the page is shared with page cache. Writes must trap, either
+    //  to do COW or to have the cached page marked dirty
+    pte = pte_mkwprotect(pte);
+    ptep_map_leaflet(fault->fault_ptep, pte, region_part);
+
+    __flush_staled_tlb(fault, region_part);
+
+    __fault_around(fault, pte);
+
+    fault_resolved(fault, NO_PREALLOC);
+}
+
 static void
 __handle_kernel_page(struct fault_context* fault)
 {
@@ -297,6 +412,8 @@ __try_resolve_fault(struct fault_context* fault)
         return false;
     }
 
+    fault->mm->stats.faults++;
+
     if (pte_isloaded(fault_pte)) {
         __handle_conflict_pte(fault);
     }
@@ -305,6 +422,7 @@ __try_resolve_fault(struct fault_context* fault)
     }
     else if (fault->vmr->mfile) {
         __handle_named_region(fault);
+        fault->mm->stats.file_faults++;
     }
     else {
         // page not present, might be a chance to introduce swap file?
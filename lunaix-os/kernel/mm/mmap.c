@@ -1,3 +1,4 @@
+#include <lunaix/fs.h>
 #include <lunaix/mm/mmap.h>
 #include <lunaix/mm/page.h>
 #include <lunaix/mm/valloc.h>
@@ -276,22 +277,36 @@ mem_sync_pages(ptr_t mnt,
     pte_t* ptep = mkptep_va(mnt, start);
     ptr_t va    = page_aligned(start);
 
+    struct v_inode* inode = region->mfile->inode;
+    struct pcache* pcache = inode->pg_cache;
+    struct pcache_pg* pg;
+
     for (; va < start + length; va += PAGE_SIZE, ptep++) {
         pte_t pte = vmm_tryptep(ptep, LFT_SIZE);
         if (pte_isnull(pte)) {
             continue;
         }
 
-        if (pte_dirty(pte)) {
-            size_t offset = va - region->start + region->foff;
-            struct v_inode* inode = region->mfile->inode;
+        size_t offset = va - region->start + region->foff;
+        pg = pcache ? pcache_lookup(pcache, offset) : NULL;
 
-            region->mfile->ops->write_page(inode, (void*)va, offset);
+        if (pte_dirty(pte)) {
+            if (pg) {
+                // mapped page is the cached one, let page cache do the job
+                pcache_set_dirty(pcache, pg);
+            } else {
+                region->mfile->ops->write_page(inode, (void*)va, offset);
+            }
 
             set_pte(ptep, pte_mkclean(pte));
             tlb_flush_vmr(region, va);
-            
-        } else if ((options & MS_INVALIDATE)) {
+        }
+
+        if (pg && (options & MS_SYNC)) {
+            pcache_commit(inode, pg);
+        }
+
+        if (!pte_dirty(pte) && (options & MS_INVALIDATE)) {
             goto invalidate;
         }
 
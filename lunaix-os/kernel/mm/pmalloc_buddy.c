@@ -1,9 +1,281 @@
+#include <lunaix/spike.h>
 #include "pmm_internal.h"
 
 // Classic buddy allocator
 
 #ifdef CONFIG_PMALLOC_BUDDY
 
-// TODO
+/*
+    Blocks are aligned on their size with respect to the absolute ppfn,
+    thus a buddy of a block is simply found by flipping the order bit.
+    Only the head of a free block carry the BUDDY_FREE flag along with
+    the order of the block, all its tail pages are left untouched.
+*/
 
-#endif
\ No newline at end of file
+#define BUDDY_FREE      0b01
+
+static inline bool
+__in_pool(struct pmem_pool* pool, struct ppage* page)
+{
+    return pool->pool_start <= page && page <= pool->pool_end;
+}
+
+static inline bool
+__free_head(struct ppage* page, size_t order)
+{
+    return (page->flags & BUDDY_FREE) && page->order == order;
+}
+
+static inline struct ppage*
+__buddy_of(struct ppage* page, size_t order)
+{
+    return ppage(ppfn(page) ^ (1UL << order));
+}
+
+static void
+__buddy_attach(struct pmem_pool* pool, struct ppage* page, size_t order)
+{
+    page->refs = 0;
+    page->type = 0;
+    page->order = order;
+    page->companion = 0;
+    page->flags |= BUDDY_FREE;
+
+    llist_append(&pool->idle_order[order], &page->sibs);
+    pool->count[order]++;
+}
+
+static void
+__buddy_detach(struct pmem_pool* pool, struct ppage* page)
+{
+    assert(page->flags & BUDDY_FREE);
+
+    llist_delete(&page->sibs);
+    pool->count[page->order]--;
+
+    page->flags &= ~BUDDY_FREE;
+}
+
+static void
+__buddy_free(struct pmem_pool* pool, struct ppage* page, size_t order)
+{
+    struct ppage* buddy;
+
+    while (order < MAX_PAGE_ORDERS) {
+        buddy = __buddy_of(page, order);
+        if (!__in_pool(pool, buddy) || !__free_head(buddy, order)) {
+            break;
+        }
+
+        __buddy_detach(pool, buddy);
+        page = MIN(page, buddy);
+        order++;
+    }
+
+    __buddy_attach(pool, page, order);
+}
+
+/**
+ * @brief Give back an arbitrary range of pages, carving it into
+ *        largest possible aligned blocks.
+ */
+static void
+__buddy_free_range(struct pmem_pool* pool,
+                   struct ppage* start,
+                   struct ppage* end)
+{
+    size_t order;
+    pfn_t pfn, left;
+
+    while (start <= end) {
+        pfn = ppfn(start);
+        left = (pfn_t)(end - start) + 1;
+
+        order = pfn ? MIN(ctz(pfn), MAX_PAGE_ORDERS) : MAX_PAGE_ORDERS;
+        while ((1UL << order) > left) {
+            order--;
+        }
+
+        __buddy_free(pool, start, order);
+        start += 1UL << order;
+    }
+}
+
+/**
+ * @brief Find the free block that contains the given page.
+ */
+static struct ppage*
+__buddy_block_of(struct pmem_pool* pool, struct ppage* page)
+{
+    struct ppage* head;
+    pfn_t pfn = ppfn(page);
+
+    for (size_t order = 0; order <= MAX_PAGE_ORDERS; order++) {
+        head = ppage(pfn & ~((1UL << order) - 1));
+        if (!__in_pool(pool, head)) {
+            break;
+        }
+
+        if (__free_head(head, order)) {
+            return head;
+        }
+    }
+
+    return NULL;
+}
+
+void
+pmm_allocator_init(struct pmem* memory)
+{
+    // nothing todo
+}
+
+void
+pmm_allocator_init_pool(struct pmem_pool* pool)
+{
+    for (int i = 0; i <= MAX_PAGE_ORDERS; i++) {
+        llist_init_head(&pool->idle_order[i]);
+        pool->count[i] = 0;
+    }
+
+    pool->stats = (struct pmem_stats){ };
+
+    struct ppage* pooled_page = pool->pool_start;
+    for (; pooled_page <= pool->pool_end; pooled_page++) {
+        *pooled_page = (struct ppage){ .pool = pool->type };
+    }
+
+    __buddy_free_range(pool, pool->pool_start, pool->pool_end);
+}
+
+void
+pmm_free_one(struct ppage* page, int type_mask)
+{
+    page = leading_page(page);
+
+    assert(page->refs);
+    assert(!reserved_page(page));
+    assert(!(page->flags & BUDDY_FREE));
+
+    if (--page->refs) {
+        return;
+    }
+
+    int order = page->order;
+    assert(order <= MAX_PAGE_ORDERS);
+
+    struct pmem_pool* pool = pmm_pool_lookup(page);
+
+    pool->stats.busy[order]--;
+    __buddy_free(pool, page, order);
+}
+
+struct ppage*
+pmm_alloc_napot_type(int pool, size_t order, ppage_type_t type)
+{
+    assert(order <= MAX_PAGE_ORDERS);
+
+    struct pmem_pool* _pool = pmm_pool_get(pool);
+    struct ppage* good_page;
+    size_t i = order;
+
+    while (i <= MAX_PAGE_ORDERS && llist_empty(&_pool->idle_order[i])) {
+        i++;
+    }
+
+    if (i > MAX_PAGE_ORDERS) {
+        _pool->stats.failed++;
+        return NULL;
+    }
+
+    good_page = list_entry(_pool->idle_order[i].next, struct ppage, sibs);
+    __buddy_detach(_pool, good_page);
+
+    // split, hand the upper halves back
+    while (i > order) {
+        i--;
+        __buddy_attach(_pool, good_page + (1UL << i), i);
+    }
+
+    for (size_t j = 0; j < (1UL << order); j++) {
+        struct ppage* page = &good_page[j];
+        page->order = order;
+        page->companion = j;
+        page->pool = _pool->type;
+        llist_init_head(&page->sibs);
+    }
+
+    assert(!good_page->refs);
+
+    good_page->refs = 1;
+    good_page->type = type;
+    _pool->stats.busy[order]++;
+
+    return good_page;
+}
+
+bool
+pmm_allocator_trymark_onhold(struct pmem_pool* pool, struct ppage* start, struct ppage* end)
+{
+    struct ppage *block, *block_end, *stop;
+
+    while (start <= end) {
+        if (reserved_page(start)) {
+            start++;
+            continue;
+        }
+
+        block = __buddy_block_of(pool, start);
+        if (!block) {
+            // in use
+            return false;
+        }
+
+        block_end = block + (1UL << block->order) - 1;
+        __buddy_detach(pool, block);
+
+        // keep whatever outside of the range free
+        if (block < start) {
+            __buddy_free_range(pool, block, start - 1);
+        }
+
+        if (end < block_end) {
+            __buddy_free_range(pool, end + 1, block_end);
+        }
+
+        stop = MIN(block_end, end);
+        for (; start <= stop; start++) {
+            set_reserved(start);
+            start->companion = 0;
+            pool->stats.reserved++;
+        }
+    }
+
+    return true;
+}
+
+bool
+pmm_allocator_trymark_unhold(struct pmem_pool* pool, struct ppage* start, struct ppage* end)
+{
+    struct ppage* run;
+
+    while (start <= end) {
+        if (!reserved_page(start)) {
+            start++;
+            continue;
+        }
+
+        run = start;
+        while (start <= end && reserved_page(start)) {
+            *start = (struct ppage){ .pool = pool->type };
+            pool->stats.reserved--;
+            start++;
+        }
+
+        __buddy_free_range(pool, run, start - 1);
+    }
+
+    return true;
+}
+
+#endif
@@ -50,11 +50,13 @@ pmm_allocator_init(struct pmem* memory)
 void
 pmm_allocator_init_pool(struct pmem_pool* pool)
 {
-    for (int i = 0; i < MAX_PAGE_ORDERS; i++) {
+    for (int i = 0; i <= MAX_PAGE_ORDERS; i++) {
         llist_init_head(&pool->idle_order[i]);
         pool->count[i] = 0;
     }
 
+    pool->stats = (struct pmem_stats){ };
+
     struct ppage* pooled_page = pool->pool_start;
     for (; pooled_page <= pool->pool_end; pooled_page++) {
         *pooled_page = (struct ppage){ };
@@ -80,6 +82,8 @@ pmm_free_one(struct ppage* page, int type_mask)
     struct pmem_pool* pool = pmm_pool_lookup(page);
     struct llist_header* bucket = &pool->idle_order[order];
 
+    pool->stats.busy[order]--;
+
     if (pool->count[order] < po_limit[order]) {
         llist_append(bucket, &page->sibs);
         pool->count[order]++;
@@ -101,9 +105,11 @@ pmm_looknext(struct pmem_pool* pool, size_t order)
 
     total = 1 << order;
     count = total;
+    pool->stats.scans++;
     do
     {
         tail = ppage_of(pool, working);
+        pool->stats.scan_pages++;
 
         if (__uninitialized_page(tail)) {
             count--;
@@ -152,11 +158,16 @@ pmm_alloc_napot_type(int pool, size_t order, ppage_type_t type)
         good_page = pmm_looknext(_pool, order);
     }
 
+    if (!good_page) {
+        _pool->stats.failed++;
+    }
+
     assert(good_page);
     assert(!good_page->refs);
     
     good_page->refs = 1;
     good_page->type = type;
+    _pool->stats.busy[order]++;
 
     return good_page;
 }
@@ -168,10 +179,12 @@ pmm_allocator_trymark_onhold(struct pmem_pool* pool, struct ppage* start, struct
         if (__uninitialized_page(start)) {
             set_reserved(start);
             __set_page_initialized(start);
+            pool->stats.reserved++;
         }
         else if (!start->refs) {
             struct ppage* lead = leading_page(start);
             llist_delete(&lead->sibs);
+            pool->count[lead->order]--;
 
             __set_pages_uninitialized(lead);
             
@@ -193,6 +206,7 @@ pmm_allocator_trymark_unhold(struct pmem_pool* pool, struct ppage* start, struct
     while (start <= end) {
         if (!__uninitialized_page(start) && reserved_page(start)) {
             __set_pages_uninitialized(start);
+            pool->stats.reserved--;
         }
 
         start++;
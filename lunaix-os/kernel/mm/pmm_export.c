@@ -0,0 +1,115 @@
+#include <lunaix/fs/twifs.h>
+#include <lunaix/mm/pmm.h>
+
+static inline size_t
+__pool_pages(struct pmem_pool* pool)
+{
+    return (size_t)(pool->pool_end - pool->pool_start) + 1;
+}
+
+static size_t
+__busy_pages(struct pmem_pool* pool)
+{
+    size_t total = 0;
+    for (int i = 0; i <= MAX_PAGE_ORDERS; i++) {
+        total += (size_t)pool->stats.busy[i] << i;
+    }
+
+    return total;
+}
+
+static size_t
+__idle_pages(struct pmem_pool* pool, int from_order)
+{
+    size_t total = 0;
+    for (int i = from_order; i <= MAX_PAGE_ORDERS; i++) {
+        total += (size_t)pool->count[i] << i;
+    }
+
+    return total;
+}
+
+static void
+__pmem_rd_pages(struct twimap* map)
+{
+    struct pmem_pool* pool = twimap_data(map, struct pmem_pool*);
+    size_t total = __pool_pages(pool);
+    size_t busy = __busy_pages(pool);
+    size_t reserved = pool->stats.reserved;
+
+    twimap_printf(map,
+                  "total %u\nbusy %u\nreserved %u\nfree %u\n",
+                  total,
+                  busy,
+                  reserved,
+                  total - busy - reserved);
+}
+
+static void
+__pmem_rd_orders(struct twimap* map)
+{
+    struct pmem_pool* pool = twimap_data(map, struct pmem_pool*);
+
+    for (int i = 0; i <= MAX_PAGE_ORDERS; i++) {
+        twimap_printf(
+          map, "%d %d %u\n", i, pool->count[i], pool->stats.busy[i]);
+    }
+}
+
+/*
+    Unusable free space index of each order, in permille. That is,
+    the fraction of idle pages that can not serve a request of the
+    given order, as they only sit in smaller blocks. Only pages that
+    are kept on the per-order idle lists are accounted.
+*/
+static void
+__pmem_rd_frag(struct twimap* map)
+{
+    struct pmem_pool* pool = twimap_data(map, struct pmem_pool*);
+    size_t idle = __idle_pages(pool, 0), usable;
+
+    for (int i = 0; i <= MAX_PAGE_ORDERS; i++) {
+        usable = __idle_pages(pool, i);
+        twimap_printf(
+          map, "%d %u\n", i, idle ? ((idle - usable) * 1000) / idle : 0);
+    }
+}
+
+static void
+__pmem_rd_failed(struct twimap* map)
+{
+    struct pmem_pool* pool = twimap_data(map, struct pmem_pool*);
+    twimap_printf(map, "%u", pool->stats.failed);
+}
+
+static void
+__pmem_rd_scan(struct twimap* map)
+{
+    struct pmem_pool* pool = twimap_data(map, struct pmem_pool*);
+    twimap_printf(map, "%u %u", pool->stats.scans, pool->stats.scan_pages);
+}
+
+static void
+pmm_export_pool(struct twifs_node* root, int index)
+{
+    struct pmem_pool* pool = pmm_pool_get(index);
+    struct twifs_node* pool_rt = twifs_dir_node(root, "pool%d", index);
+
+    twimap_entry_simple(pool_rt, "pages", pool, __pmem_rd_pages);
+    twimap_entry_simple(pool_rt, "orders", pool, __pmem_rd_orders);
+    twimap_entry_simple(pool_rt, "fragmentation", pool, __pmem_rd_frag);
+    twimap_entry_simple(pool_rt, "alloc_failed", pool, __pmem_rd_failed);
+    twimap_entry_simple(pool_rt, "scan", pool, __pmem_rd_scan);
+}
+
+void
+pmm_export()
+{
+    struct twifs_node* mm_root = twifs_dir_node(NULL, "mm");
+    struct twifs_node* pmem_root = twifs_dir_node(mm_root, "pmem");
+
+    for (int i = 0; i < POOL_COUNT; i++) {
+        pmm_export_pool(pmem_root, i);
+    }
+}
+EXPORT_TWIFS_PLUGIN(pmem_stat, pmm_export);
@@ -60,14 +60,14 @@ __valloc(unsigned int size,
 }
 
 void
-__vfree(void* ptr, struct cake_pile** segregate_list, size_t len)
+__vfree(void* ptr)
 {
-    size_t i = 0;
-    for (; i < len; i++) {
-        if (cake_release(segregate_list[i], ptr)) {
-            return;
-        }
+    struct cake_pile* pile = cake_pile_of(ptr);
+    if (!pile) {
+        return;
     }
+
+    cake_release(pile, ptr);
 }
 
 void*
@@ -100,7 +100,7 @@ vcalloc(unsigned int size, unsigned int count)
 void
 vfree(void* ptr)
 {
-    __vfree(ptr, piles, CLASS_LEN(piles_names));
+    __vfree(ptr);
 }
 
 void
@@ -110,7 +110,7 @@ vfree_safe(void* ptr)
         return;
     }
 
-    __vfree(ptr, piles, CLASS_LEN(piles_names));
+    __vfree(ptr);
 }
 
 void*
@@ -130,7 +130,7 @@ vzalloc_dma(unsigned int size)
 void
 vfree_dma(void* ptr)
 {
-    __vfree(ptr, piles_dma, CLASS_LEN(piles_names_dma));
+    __vfree(ptr);
 }
 
 inline void must_inline
@@ -159,6 +159,7 @@ dup_proc()
     }
     
     pcb->parent = __current;
+    pcb->nice = __current->nice;
 
     // FIXME need a more elagent refactoring
     if (__current->cmd) {
@@ -0,0 +1,203 @@
+/**
+ * @file futex.c
+ * @brief Block on a user space word until somebody wakes it up, the
+ * slow path of user space locks.
+ *
+ * Waiters are keyed by (address space, user address), thus threads of
+ * a process share a queue on the same word. A queue is created by the
+ * first waiter and freed once it runs empty.
+ */
+
+#include <lunaix/ds/hashtable.h>
+#include <lunaix/ds/waitq.h>
+#include <lunaix/futex.h>
+#include <lunaix/mm/valloc.h>
+#include <lunaix/process.h>
+#include <lunaix/signal.h>
+#include <lunaix/status.h>
+#include <lunaix/syscall.h>
+#include <lunaix/syscall_utils.h>
+#include <lunaix/timer.h>
+
+#include <usr/lunaix/threads.h>
+
+#include <sys/mm/mm_defs.h>
+
+#define FUTEX_HASH_BITS 6
+
+struct futex
+{
+    struct hlist_node head;
+    struct proc_mm* mm;
+    ptr_t uaddr;
+    waitq_t waiters;
+};
+
+static DECLARE_HASHTABLE(futex_table, 1 << FUTEX_HASH_BITS);
+
+static inline u32_t
+__futex_hash(struct proc_mm* mm, ptr_t uaddr)
+{
+    return hash_32((u32_t)mm ^ (u32_t)uaddr, FUTEX_HASH_BITS);
+}
+
+static struct futex*
+__futex_get(struct proc_mm* mm, ptr_t uaddr)
+{
+    struct futex *pos, *n;
+    hashtable_hash_foreach(futex_table, __futex_hash(mm, uaddr), pos, n, head)
+    {
+        if (pos->mm == mm && pos->uaddr == uaddr) {
+            return pos;
+        }
+    }
+
+    return NULL;
+}
+
+static struct futex*
+__futex_get_or_new(struct proc_mm* mm, ptr_t uaddr)
+{
+    struct futex* futex = __futex_get(mm, uaddr);
+    if (futex) {
+        return futex;
+    }
+
+    if (!(futex = valloc(sizeof(*futex)))) {
+        return NULL;
+    }
+
+    futex->mm = mm;
+    futex->uaddr = uaddr;
+    waitq_init(&futex->waiters);
+    hashtable_hash_in(futex_table, &futex->head, __futex_hash(mm, uaddr));
+
+    return futex;
+}
+
+static void
+__futex_put(struct futex* futex)
+{
+    if (!futex || !waitq_empty(&futex->waiters)) {
+        return;
+    }
+
+    hlist_delete(&futex->head);
+    vfree(futex);
+}
+
+static void
+__futex_timeout(void* payload)
+{
+    struct thread* thread = (struct thread*)payload;
+
+    // pwake_one expects every queued thread to be blocked
+    waitq_cancel_wait(&thread->waitqueue);
+
+    if (proc_hanged(thread)) {
+        resume_thread(thread);
+    }
+}
+
+static int
+__futex_wait(int* uaddr, int val, int timeout)
+{
+    struct proc_mm* mm = vmspace(__current);
+    // owned by thread, so it is disarmed should we get killed in wait
+    struct lx_timer* timer = &current_thread->sleep.timeout;
+    struct futex* futex;
+    int errno = 0;
+
+    // interrupt is off during syscall, no waker can sneak in between
+    // the check and the enqueue
+    if (*uaddr != val) {
+        return EAGAIN;
+    }
+
+    if (!(futex = __futex_get_or_new(mm, (ptr_t)uaddr))) {
+        return ENOMEM;
+    }
+
+    timer_setup(timer, __futex_timeout, current_thread, 0);
+    if (timeout >= 0 && timer_arm(timer, hwtimer_to_ticks(timeout, TIME_MS))) {
+        __futex_put(futex);
+        return ENOMEM;
+    }
+
+    pwait(&futex->waiters);
+
+    // pwait turns interrupt back on, keep the timer quiet while we
+    // find out why we woke.
+    cpu_disable_interrupt();
+
+    if (timeout >= 0 && !timer_armed(timer)) {
+        errno = ETIMEDOUT;
+    } else if (sigset_test(pending_sigs(current_thread), _SIGINT)) {
+        errno = EINTR;
+    }
+
+    timer_disarm(timer);
+
+    // the queue might have been freed by a waker that drained it
+    __futex_put(__futex_get(mm, (ptr_t)uaddr));
+
+    return errno;
+}
+
+static int
+__futex_wake(int* uaddr, int nr)
+{
+    struct futex* futex = __futex_get(vmspace(__current), (ptr_t)uaddr);
+    int woken = 0;
+
+    if (!futex) {
+        return 0;
+    }
+
+    while (woken < nr && !waitq_empty(&futex->waiters)) {
+        pwake_one(&futex->waiters);
+        woken++;
+    }
+
+    __futex_put(futex);
+
+    return woken;
+}
+
+void
+futex_reclaim(struct proc_mm* mm)
+{
+    struct futex *pos, *n;
+
+    for (u32_t i = 0; i < (1U << FUTEX_HASH_BITS); i++) {
+        hashtable_bucket_foreach(&futex_table[i], pos, n, head)
+        {
+            if (pos->mm == mm) {
+                __futex_put(pos);
+            }
+        }
+    }
+}
+
+__DEFINE_LXSYSCALL4(int, futex, int*, uaddr, int, op, int, val, int, timeout)
+{
+    int errno;
+
+    if (!uaddr || kernel_addr((ptr_t)uaddr) || ((ptr_t)uaddr & 0x3)) {
+        return DO_STATUS(EINVAL);
+    }
+
+    switch (op) {
+        case FUTEX_WAIT:
+            errno = __futex_wait(uaddr, val, timeout);
+            break;
+        case FUTEX_WAKE:
+            errno = __futex_wake(uaddr, val);
+            break;
+        default:
+            errno = EINVAL;
+            break;
+    }
+
+    return DO_STATUS_OR_RETURN(errno);
+}
@@ -5,6 +5,7 @@
 #include <sys/cpu.h>
 
 #include <lunaix/fs/taskfs.h>
+#include <lunaix/futex.h>
 #include <lunaix/mm/cake.h>
 #include <lunaix/mm/mmap.h>
 #include <lunaix/mm/pmm.h>
@@ -18,6 +19,7 @@
 #include <lunaix/status.h>
 #include <lunaix/syscall.h>
 #include <lunaix/syslog.h>
+#include <lunaix/vdso.h>
 #include <lunaix/pcontext.h>
 #include <lunaix/kpreempt.h>
 
@@ -45,18 +47,128 @@ sched_init()
     sched_ctx = (struct scheduler){
         .procs = vzalloc(PROC_TABLE_SIZE), .ptable_len = 0, .procs_index = 0};
     
-    llist_init_head(&sched_ctx.sleepers);
+    for (int i = 0; i < 2; i++) {
+        struct sched_runq* rq = &sched_ctx.runqs[i];
+        for (int j = 0; j < SCHED_PRIO_LEVELS; j++) {
+            llist_init_head(&rq->levels[j]);
+        }
+    }
+
+    sched_ctx.active = &sched_ctx.runqs[0];
+    sched_ctx.expired = &sched_ctx.runqs[1];
+}
+
+static inline int
+__sched_level(struct thread* thread)
+{
+    return thread->process->nice - SCHED_NICE_MIN;
+}
+
+static void
+__runq_add(struct sched_runq* rq, struct thread* thread)
+{
+    struct runq_node* node = &thread->schedq;
+
+    if (node->rq) {
+        // already queued, keep its place.
+        return;
+    }
+
+    int lvl = __sched_level(thread);
+
+    llist_append(&rq->levels[lvl], &node->sibs);
+    rq->bitmap[lvl / 32] |= 1 << (lvl % 32);
+    rq->nr_ready++;
+
+    node->rq = rq;
+    node->level = lvl;
+}
+
+static void
+__runq_remove(struct thread* thread)
+{
+    struct runq_node* node = &thread->schedq;
+    struct sched_runq* rq = node->rq;
+
+    if (!rq) {
+        return;
+    }
+
+    int lvl = node->level;
+
+    llist_delete(&node->sibs);
+    if (llist_empty(&rq->levels[lvl])) {
+        rq->bitmap[lvl / 32] &= ~(1 << (lvl % 32));
+    }
+
+    rq->nr_ready--;
+    node->rq = NULL;
+}
+
+static struct thread*
+__runq_first(struct sched_runq* rq)
+{
+    for (int i = 0; i < SCHED_BITMAP_LEN; i++) {
+        u32_t bits = rq->bitmap[i];
+        if (!bits) {
+            continue;
+        }
+
+        int lvl = i * 32 + ctz(bits);
+        return list_entry(rq->levels[lvl].next, struct thread, schedq.sibs);
+    }
+
+    return NULL;
+}
+
+void
+resume_thread(struct thread* thread)
+{
+    thread->state = PS_READY;
+    __runq_add(sched_ctx.active, thread);
+}
+
+void
+sched_recheck(struct thread* thread)
+{
+    if (proc_terminated(thread) || thread->state == PS_RUNNING) {
+        return;
+    }
+
+    __runq_add(sched_ctx.active, thread);
+}
+
+int
+sched_nr_ready()
+{
+    return sched_ctx.active->nr_ready + sched_ctx.expired->nr_ready;
+}
+
+time_t
+sched_timeslice(struct thread* thread)
+{
+    if (unlikely(!thread->process)) {
+        return SCHED_TIME_SLICE;
+    }
+
+    int lvl = __sched_level(thread);
+
+    // default nice (0) get exactly SCHED_TIME_SLICE.
+    return SCHED_TIME_SLICE * (SCHED_PRIO_LEVELS - lvl) / -SCHED_NICE_MIN;
 }
 
 void
 run(struct thread* thread)
 {
+    __runq_remove(thread);
+
     thread->state = PS_RUNNING;
     thread->process->state = PS_RUNNING;
     thread->process->th_active = thread;
 
     procvm_mount_self(vmspace(thread->process));
     set_current_executing(thread);
+    vdso_update(thread);
 
     switch_context();
     fail("unexpected return from switching");
@@ -135,38 +247,22 @@ can_schedule(struct thread* thread)
             && proc_runnable(thread->process);
 }
 
-void
-check_sleepers()
+static void
+__sleeper_wakeup(void* payload)
 {
-    struct thread *pos, *n;
-    time_t now = clock_systime() / 1000;
+    struct thread* thread = (struct thread*)payload;
 
-    llist_for_each(pos, n, &sched_ctx.sleepers, sleep.sleepers)
-    {
-        if (proc_terminated(pos)) {
-            goto del;
-        }
-
-        time_t wtime = pos->sleep.wakeup_time;
-        time_t atime = pos->sleep.alarm_time;
-
-        if (wtime && now >= wtime) {
-            pos->sleep.wakeup_time = 0;
-            pos->state = PS_READY;
-        }
-
-        if (atime && now >= atime) {
-            pos->sleep.alarm_time = 0;
-            thread_setsignal(pos, _SIGALRM);
-        }
-
-        if (!wtime && !atime) {
-        del:
-            llist_delete(&pos->sleep.sleepers);
-        }
+    if (proc_hanged(thread)) {
+        resume_thread(thread);
     }
 }
 
+static void
+__sleeper_alarm(void* payload)
+{
+    thread_setsignal((struct thread*)payload, _SIGALRM);
+}
+
 void
 schedule()
 {
@@ -179,34 +275,42 @@ schedule()
         current_thread->state = PS_READY;
         __current->state = PS_READY;
 
+        // had its turn, wait for next round.
+        __runq_add(sched_ctx.expired, current_thread);
     }
 
     procvm_unmount_self(vmspace(__current));
-    check_sleepers();
 
-    // round-robin scheduler
-    
-    struct thread* current = current_thread;
-    struct thread* to_check = current;
-    
+    struct thread* to_check;
+    struct sched_runq* rq;
+
     do {
-        to_check = list_next(to_check, struct thread, sched_sibs);
+        rq = sched_ctx.active;
 
-        if (can_schedule(to_check)) {
-            break;
+        if (!rq->nr_ready) {
+            sched_ctx.active = sched_ctx.expired;
+            sched_ctx.expired = rq;
+            rq = sched_ctx.active;
         }
 
-        if (to_check == current) {
+        to_check = __runq_first(rq);
+
+        if (!to_check) {
             // FIXME do something less leathal here
             fail("Ran out of threads!")
-            goto done;  
         }
 
-    } while (1);
+        /*
+            Entries might be staled (e.g., blocked, terminated or 
+            stopped after being queued), we drop them in place, 
+            they will be re-queued when become ready again.
+        */
+        __runq_remove(to_check);
+
+    } while (!can_schedule(to_check));
 
     sched_ctx.procs_index = to_check->process->pid;
 
-done:
     intc_notify_eos(0);
     run(to_check);
 
@@ -226,17 +330,16 @@ __DEFINE_LXSYSCALL1(unsigned int, sleep, unsigned int, seconds)
         return 0;
     }
 
-    time_t systime = clock_systime() / 1000;
     struct haybed* bed = &current_thread->sleep;
+    ticks_t tps = hwtimer_to_ticks(1, TIME_SEC);
 
-    if (bed->wakeup_time) {
-        return (bed->wakeup_time - systime);
+    if (timer_armed(&bed->wakeup)) {
+        return timer_remaining(&bed->wakeup) / tps;
     }
 
-    bed->wakeup_time = systime + seconds;
-
-    if (llist_empty(&bed->sleepers)) {
-        llist_append(&sched_ctx.sleepers, &bed->sleepers);
+    // nothing slept, should the timer fail to be armed.
+    if (timer_arm(&bed->wakeup, seconds * tps)) {
+        return seconds;
     }
 
     store_retval(seconds);
@@ -250,17 +353,42 @@ __DEFINE_LXSYSCALL1(unsigned int, sleep, unsigned int, seconds)
 __DEFINE_LXSYSCALL1(unsigned int, alarm, unsigned int, seconds)
 {
     struct haybed* bed = &current_thread->sleep;
-    time_t prev_ddl = bed->alarm_time;
-    time_t now = clock_systime() / 1000;
+    ticks_t tps = hwtimer_to_ticks(1, TIME_SEC);
+    time_t prev_left = timer_remaining(&bed->alarm) / tps;
+
+    if (seconds) {
+        if (timer_arm(&bed->alarm, seconds * tps)) {
+            syscall_result(ENOMEM);
+            return 0;
+        }
+    } else {
+        timer_disarm(&bed->alarm);
+    }
+
+    return prev_left;
+}
 
-    bed->alarm_time = seconds ? now + seconds : 0;
+/*
+    As nice(2), the new nice value is returned, which can well be negative.
+    A negative return is thus not an error status, errno tells.
+*/
+__DEFINE_LXSYSCALL1(int, nice, int, inc)
+{
+    int nice = __current->nice + inc;
 
-    struct proc_info* root_proc = sched_ctx.procs[0];
-    if (llist_empty(&bed->sleepers)) {
-        llist_append(&sched_ctx.sleepers, &bed->sleepers);
+    // only the privileged one can ask for a bigger share.
+    if (inc < 0 && !kernel_process(__current)) {
+        syscall_result(EPERM);
+        return -1;
     }
 
-    return prev_ddl ? (prev_ddl - now) : 0;
+    nice = MAX(nice, SCHED_NICE_MIN);
+    nice = MIN(nice, SCHED_NICE_MAX);
+
+    __current->nice = nice;
+
+    syscall_result(0);
+    return nice;
 }
 
 __DEFINE_LXSYSCALL1(void, exit, int, status)
@@ -362,7 +490,10 @@ alloc_thread(struct proc_info* process) {
 
     th->state = PS_CREATED;
     
-    llist_init_head(&th->sleep.sleepers);
+    timer_setup(&th->sleep.wakeup, __sleeper_wakeup, th, 0);
+    timer_setup(&th->sleep.alarm, __sleeper_alarm, th, 0);
+    timer_setup(&th->sleep.timeout, NULL, th, 0);
+    llist_init_head(&th->schedq.sibs);
     llist_init_head(&th->sched_sibs);
     llist_init_head(&th->proc_sibs);
     waitq_init(&th->waitqueue);
@@ -422,7 +553,8 @@ commit_thread(struct thread* thread) {
 
     sched_ctx.ttable_len++;
     process->thread_count++;
-    thread->state = PS_READY;
+
+    resume_thread(thread);
 }
 
 void
@@ -459,12 +591,21 @@ destory_thread(struct thread* thread)
     cake_ensure_valid(thread);
     
     struct proc_info* proc = thread->process;
+    bool queued = !waitq_empty(&thread->waitqueue);
 
+    __runq_remove(thread);
     llist_delete(&thread->sched_sibs);
     llist_delete(&thread->proc_sibs);
-    llist_delete(&thread->sleep.sleepers);
+    timer_disarm(&thread->sleep.wakeup);
+    timer_disarm(&thread->sleep.alarm);
+    timer_disarm(&thread->sleep.timeout);
     waitq_cancel_wait(&thread->waitqueue);
 
+    if (queued) {
+        // might be the last waiter of a futex queue
+        futex_reclaim(vmspace(proc));
+    }
+
     thread_release_mem(thread);
 
     proc->thread_count--;
@@ -99,6 +99,9 @@ __set_signal(struct thread* thread, signum_t signum)
     if (sig) {
         sig->sender = __current->pid;
     }
+
+    // signal may awake a paused, blocked or stopped thread
+    sched_recheck(thread);
 }
 
 static inline void must_inline
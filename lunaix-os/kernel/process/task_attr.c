@@ -22,6 +22,25 @@ __read_pgid(struct twimap* map)
     twimap_printf(map, "%d", proc->pgid);
 }
 
+void
+__read_nice(struct twimap* map)
+{
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    twimap_printf(map, "%d", proc->nice);
+}
+
+void
+__read_faults(struct twimap* map)
+{
+    struct proc_info* proc = twimap_data(map, struct proc_info*);
+    struct proc_mm* mm = vmspace(proc);
+    twimap_printf(map,
+                  "%u %u %u",
+                  mm->stats.faults,
+                  mm->stats.file_faults,
+                  mm->stats.mapped_around);
+}
+
 void
 __read_children(struct twimap* map)
 {
@@ -84,6 +103,14 @@ export_task_attr()
     map->read = __read_pgid;
     taskfs_export_attr("pgid", map);
 
+    map = twimap_create(NULL);
+    map->read = __read_nice;
+    taskfs_export_attr("nice", map);
+
+    map = twimap_create(NULL);
+    map->read = __read_faults;
+    taskfs_export_attr("faults", map);
+
     map = twimap_create(NULL);
     map->read = __read_children;
     map->go_next = __next_children;
@@ -47,43 +47,74 @@ taskfs_mknod(struct v_dnode* dnode, pid_t pid, int sub_counter, int itype)
     return 0;
 }
 
+static bool
+__taskfs_cursor_valid(struct dir_cursor* cursor,
+                      struct llist_header* head,
+                      int index)
+{
+    struct proc_info* proc;
+
+    if (!cursor->pos || cursor->index != (u32_t)index) {
+        return false;
+    }
+
+    if (cursor->pos == head || head == &attributes) {
+        return true;
+    }
+
+    // the task it rests on might had gone
+    proc = get_process(cursor->tag);
+    return proc && &proc->tasks == cursor->pos && !llist_empty(&proc->tasks);
+}
+
 int
 taskfs_readdir(struct v_file* file, struct dir_context* dctx)
 {
     struct v_inode* inode = file->inode;
+    struct dir_cursor* cursor = &file->dcursor;
     pid_t pid = inode->id >> 16;
-    int counter = 0;
+    struct llist_header *head, *pos;
+    struct task_attribute* attr;
+    struct proc_info* proc;
+    char name[VFS_NAME_MAXLEN];
 
     if ((inode->id & COUNTER_MASK)) {
         return ENOTDIR;
     }
 
-    if (pid) {
-        struct task_attribute *pos, *n;
-        llist_for_each(pos, n, &attributes, siblings)
-        {
-            if (counter == dctx->index) {
-                dctx->read_complete_callback(
-                  dctx, pos->key_val, VFS_NAME_MAXLEN, DT_FILE);
-                return 1;
+    head = pid ? &attributes : &get_process(0)->tasks;
+
+    if (!__taskfs_cursor_valid(cursor, head, dctx->index)) {
+        // count from the start
+        pos = head;
+        for (int i = 0; i < dctx->index; i++) {
+            if ((pos = pos->next) == head) {
+                return 0;
             }
-            counter++;
         }
+        cursor->pos = pos;
+    }
+
+    if ((pos = cursor->pos->next) == head) {
         return 0;
     }
 
-    char name[VFS_NAME_MAXLEN];
-    struct proc_info *root = get_process(pid), *pos, *n;
-    llist_for_each(pos, n, &root->tasks, tasks)
-    {
-        if (counter == dctx->index) {
-            ksnprintf(name, VFS_NAME_MAXLEN, "%d", pos->pid);
-            dctx->read_complete_callback(dctx, name, VFS_NAME_MAXLEN, DT_DIR);
-            return 1;
-        }
-        counter++;
+    cursor->pos = pos;
+    cursor->index = dctx->index + 1;
+
+    if (pid) {
+        attr = list_entry(pos, struct task_attribute, siblings);
+        dctx->read_complete_callback(
+          dctx, attr->key_val, VFS_NAME_MAXLEN, DT_FILE);
+        return 1;
     }
-    return 0;
+
+    proc = list_entry(pos, struct proc_info, tasks);
+    cursor->tag = proc->pid;
+
+    ksnprintf(name, VFS_NAME_MAXLEN, "%d", proc->pid);
+    dctx->read_complete_callback(dctx, name, VFS_NAME_MAXLEN, DT_DIR);
+    return 1;
 }
 
 // ascii to pid
@@ -221,6 +252,7 @@ void
 taskfs_init()
 {
     struct filesystem* taskfs = fsm_new_fs("taskfs", 5);
+    taskfs->types |= FSTYPE_PSEUDO;
     taskfs->mount = taskfs_mount;
 
     fsm_register(taskfs);
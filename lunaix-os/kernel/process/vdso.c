@@ -0,0 +1,169 @@
+/**
+ * @file vdso.c
+ * @brief A per-process read-only page carrying the frequently queried
+ * kernel data (time, pid, tid), so that userspace can read them without
+ * a trap.
+ *
+ * Only the running thread can read its page, thus kernel just need to
+ * keep the page of current process fresh, on every tick and switch.
+ */
+
+#include <lunaix/clock.h>
+#include <lunaix/mm/mmap.h>
+#include <lunaix/mm/page.h>
+#include <lunaix/mm/region.h>
+#include <lunaix/mm/vmm.h>
+#include <lunaix/status.h>
+#include <lunaix/vdso.h>
+
+#include <sys/mm/mm_defs.h>
+
+#include <klibc/string.h>
+
+static inline struct lx_vdso*
+__vdso_of(struct proc_info* proc)
+{
+    struct mm_region* region = vmspace(proc)->vdso;
+    return region ? (struct lx_vdso*)region->data : NULL;
+}
+
+static inline void
+__vdso_set_epoch(struct lx_vdso* vdso)
+{
+    ticks_t now = hwtimer_current_systicks();
+
+    // so that epoch + systicks / tick_freq is clock_unixtime. Both run
+    //  off the same tick, thus it holds for good once set.
+    vdso->systicks = now;
+    vdso->epoch = clock_unixtime() - now / vdso->tick_freq;
+}
+
+static inline void
+__vdso_write_begin(struct lx_vdso* vdso)
+{
+    vdso->seq++;
+    barrier();
+}
+
+static inline void
+__vdso_write_end(struct lx_vdso* vdso)
+{
+    barrier();
+    vdso->seq++;
+}
+
+static int
+__vdso_install(struct mm_region* region, ptr_t vm_mnt)
+{
+    struct proc_mm* mm = region->proc_vms;
+    struct leaflet* leaflet;
+    struct lx_vdso* vdso;
+
+    region->data = NULL;
+
+    if (!(leaflet = alloc_leaflet(0))) {
+        return ENOMEM;
+    }
+
+    if (!(vdso = (struct lx_vdso*)vmap(leaflet, KERNEL_DATA))) {
+        leaflet_return(leaflet);
+        return ENOMEM;
+    }
+
+    memset(vdso, 0, PAGE_SIZE);
+    vdso->tick_freq = systimer->running_freq;
+    __vdso_set_epoch(vdso);
+    vdso->pid = mm->proc->pid;
+
+    // one reference for kernel, one for user mapping
+    leaflet_borrow(leaflet);
+    ptep_map_leaflet(mkptep_va(vm_mnt, region->start),
+                     mkpte_prot(region_pteprot(region)),
+                     leaflet);
+
+    region->data = vdso;
+    mm_index((void**)&mm->vdso, region);
+
+    return 0;
+}
+
+static void
+__vdso_copied(struct mm_region* region)
+{
+    struct proc_mm* mm = region->proc_vms;
+    pte_t* ptep = mkptep_va(mm->vm_mnt, region->start);
+    pte_t pte = pte_at(ptep);
+
+    // still indexed by parent, and sharing its page
+    region->index = NULL;
+
+    set_pte(ptep, null_pte);
+    if (pte_isloaded(pte)) {
+        leaflet_return(pte_leaflet(pte));
+    }
+
+    __vdso_install(region, mm->vm_mnt);
+}
+
+static void
+__vdso_destruct(struct mm_region* region)
+{
+    struct leaflet* leaflet;
+    ptr_t vdso = (ptr_t)region->data;
+
+    if (!vdso) {
+        return;
+    }
+
+    leaflet = pte_leaflet(pte_at(mkptep_va(VMS_SELF, vdso)));
+    vunmap(vdso, leaflet);
+    leaflet_return(leaflet);
+}
+
+ptr_t
+vdso_map(struct proc_mm* mm, ptr_t vm_mnt)
+{
+    struct mm_region* region;
+    struct mmap_param param = { .vms_mnt = vm_mnt,
+                                .pvms = mm,
+                                .mlen = PAGE_SIZE,
+                                .proct = PROT_READ,
+                                .flags = MAP_SHARED,
+                                .type = REGION_TYPE_VARS };
+    ptr_t addr = USR_MMAP;
+
+    if (mm->vdso) {
+        return mm->vdso->start;
+    }
+
+    if (mmap_user((void**)&addr, &region, addr, NULL, &param)) {
+        return 0;
+    }
+
+    region->region_copied = __vdso_copied;
+    region->destruct_region = __vdso_destruct;
+
+    if (__vdso_install(region, vm_mnt)) {
+        mem_unmap_region(vm_mnt, region);
+        return 0;
+    }
+
+    return region->start;
+}
+
+void
+vdso_update(struct thread* thread)
+{
+    struct lx_vdso* vdso;
+
+    if (!thread || !(vdso = __vdso_of(thread->process))) {
+        return;
+    }
+
+    __vdso_write_begin(vdso);
+
+    vdso->systicks = hwtimer_current_systicks();
+    vdso->tid = thread->tid;
+
+    __vdso_write_end(vdso);
+}
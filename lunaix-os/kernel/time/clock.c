@@ -2,9 +2,54 @@
 #include <lunaix/device.h>
 #include <lunaix/fs/twifs.h>
 #include <lunaix/spike.h>
+#include <lunaix/status.h>
+#include <lunaix/syscall.h>
+#include <lunaix/syscall_utils.h>
+#include <lunaix/timer.h>
+
+#include <usr/lunaix/time_defs.h>
+
+#include <sys/cpu.h>
+#include <sys/muldiv64.h>
 
 #include <klibc/string.h>
 
+#define NS_PER_SEC 1000000000U
+
+// seconds between two checks of the clock against RTC
+#define CLOCK_RESYNC_INTERVAL 600
+
+// fraction bits of the cycle to nanosecond multiplier
+#define CLOCK_SHIFT 24
+
+/*
+    Time is kept in software, RTC is only read at boot and on resync.
+
+    Monotonic time is the nanoseconds up to the last tick, plus cycles
+    elapsed since then, scaled by a multiplier calibrated against the
+    ticks. It has tick resolution until calibrated, or without a cycle
+    counter at all.
+
+    Realtime is monotonic time plus the offset taken at last sync. Its
+    whole seconds are advanced on tick, for clock_unixtime.
+*/
+static struct
+{
+    u64_t tick_ns;     // monotonic time of the last tick
+    u64_t tick_cycles; // cycle counter at the last tick
+    u64_t last_ns;     // latest monotonic time handed out
+    u64_t rt_offset;   // realtime - monotonic
+    u64_t next_sec;    // monotonic time for unix_sec to move on
+    u64_t calib_cycles;
+    ticks_t calib_ticks;
+    ticks_t last_ticks;
+    time_t unix_sec;
+    u32_t ns_per_tick;
+    u32_t mult; // nanoseconds per cycle, in 2^-CLOCK_SHIFT
+    bool has_cycles;
+    bool synced;
+} clk;
+
 void
 __clock_read_systime(struct twimap* map)
 {
@@ -50,12 +95,144 @@ clock_build_mapping()
 }
 EXPORT_TWIFS_PLUGIN(sys_clock, clock_build_mapping);
 
-time_t
-clock_unixtime()
+static void
+__clock_sync(void* unused)
 {
     datetime_t dt;
+    time_t now;
+    u64_t mono;
+
+    if (!sysrtc) {
+        return;
+    }
+
     hwrtc_walltime(&dt);
-    return datetime_tounix(&dt);
+    now = datetime_tounix(&dt);
+
+    // RTC counts in whole seconds, only step if we are off by more
+    if (clk.synced && (u32_t)(now - clk.unix_sec + 1) <= 2) {
+        return;
+    }
+
+    mono = clock_monotonic();
+    clk.rt_offset = (u64_t)now * NS_PER_SEC - mono;
+    clk.next_sec = mono + NS_PER_SEC;
+    clk.unix_sec = now;
+    clk.synced = true;
+}
+
+static void
+__clock_start()
+{
+    clk.ns_per_tick = NS_PER_SEC / systimer->running_freq;
+    clk.has_cycles = cpu_has_cycles();
+
+    timer_run_second(
+      CLOCK_RESYNC_INTERVAL, __clock_sync, NULL, TIMER_MODE_PERIODIC);
+}
+
+static void
+__clock_calibrate(ticks_t now)
+{
+    u64_t cycles, ns;
+
+    if (!clk.calib_cycles) {
+        clk.calib_ticks = now;
+        clk.calib_cycles = clk.tick_cycles;
+        return;
+    }
+
+    // measure over 1/10 second
+    if (now - clk.calib_ticks < systimer->running_freq / 10) {
+        return;
+    }
+
+    cycles = clk.tick_cycles - clk.calib_cycles;
+    if ((cycles >> 32)) {
+        // idled for too long, start over
+        clk.calib_cycles = 0;
+        return;
+    }
+
+    ns = (u64_t)(now - clk.calib_ticks) * clk.ns_per_tick;
+    clk.mult = (u32_t)udiv64(ns << CLOCK_SHIFT, (u32_t)cycles);
+}
+
+void
+clock_tick(ticks_t now)
+{
+    if (unlikely(!clk.ns_per_tick)) {
+        __clock_start();
+    }
+
+    clk.tick_ns += (u64_t)(now - clk.last_ticks) * clk.ns_per_tick;
+    clk.last_ticks = now;
+
+    if (clk.has_cycles) {
+        clk.tick_cycles = cpu_cycles();
+        if (unlikely(!clk.mult)) {
+            __clock_calibrate(now);
+        }
+    }
+
+    while (clk.tick_ns >= clk.next_sec) {
+        clk.next_sec += NS_PER_SEC;
+        clk.unix_sec++;
+    }
+}
+
+u64_t
+clock_monotonic()
+{
+    u64_t ns;
+    u32_t state = cpu_save_interrupt();
+
+    ns = clk.tick_ns;
+    if (clk.mult) {
+        ns += ((cpu_cycles() - clk.tick_cycles) * clk.mult) >> CLOCK_SHIFT;
+    }
+
+    // the tick might be pending while cycles keep going
+    if (ns < clk.last_ns) {
+        ns = clk.last_ns;
+    }
+    clk.last_ns = ns;
+
+    cpu_restore_interrupt(state);
+    return ns;
+}
+
+u64_t
+clock_realtime()
+{
+    return clock_monotonic() + clk.rt_offset;
+}
+
+time_t
+clock_unixtime()
+{
+    return clk.unix_sec;
+}
+
+__DEFINE_LXSYSCALL2(int, clock_gettime, int, clockid, struct timespec*, ts)
+{
+    u64_t ns;
+
+    switch (clockid) {
+        case CLOCK_MONOTONIC:
+            ns = clock_monotonic();
+            break;
+        case CLOCK_REALTIME:
+            ns = clock_realtime();
+            break;
+        default:
+            return DO_STATUS(EINVAL);
+    }
+
+    ts->tv_nsec = do_udiv64(ns, NS_PER_SEC);
+    ts->tv_sec = (u32_t)ns;
+
+    return 0;
 }
 
 time_t
@@ -94,4 +271,6 @@ clock_init()
 
         pos->init(pos);
     }
+
+    __clock_sync(NULL);
 }
\ No newline at end of file
@@ -10,15 +10,21 @@
  *
  */
 
+#include <lunaix/clock.h>
 #include <lunaix/mm/cake.h>
 #include <lunaix/mm/valloc.h>
 #include <lunaix/sched.h>
 #include <lunaix/spike.h>
+#include <lunaix/status.h>
 #include <lunaix/syslog.h>
 #include <lunaix/timer.h>
 #include <lunaix/pcontext.h>
+#include <lunaix/vdso.h>
 
 #include <hal/hwtimer.h>
+#include <sys/cpu.h>
+
+#include <klibc/string.h>
 
 LOG_MODULE("TIMER");
 
@@ -27,22 +33,27 @@ timer_update();
 
 static volatile struct lx_timer_context* timer_ctx = NULL;
 
-static volatile u32_t sched_ticks = 0;
 static volatile u32_t sched_ticks_counter = 0;
 
 static struct cake_pile* timer_pile;
 
+#define TIMER_HEAP_INIT 64
+#define TIMER_IDLE_MAX SYS_TIMER_FREQUENCY_HZ
+
+// wrap-around safe comparison on systicks
+#define ticks_before(a, b) ((int)((a) - (b)) < 0)
+
 void
 timer_init_context()
 {
     timer_pile = cake_new_pile("timer", sizeof(struct lx_timer), 1, 0);
     timer_ctx =
-      (struct lx_timer_context*)valloc(sizeof(struct lx_timer_context));
+      (struct lx_timer_context*)vzalloc(sizeof(struct lx_timer_context));
 
     assert_msg(timer_ctx, "Fail to initialize timer contex");
 
-    timer_ctx->active_timers = (struct lx_timer*)cake_grab(timer_pile);
-    llist_init_head(&timer_ctx->active_timers->link);
+    timer_ctx->capacity = TIMER_HEAP_INIT;
+    timer_ctx->timers = vcalloc(sizeof(struct lx_timer*), TIMER_HEAP_INIT);
 }
 
 void
@@ -54,10 +65,114 @@ timer_init()
 
     timer_ctx->base_frequency = hwtimer_base_frequency();
 
-    sched_ticks = (SYS_TIMER_FREQUENCY_HZ * SCHED_TIME_SLICE) / 1000;
     sched_ticks_counter = 0;
 }
 
+static inline void
+__heap_place(struct lx_timer** heap, unsigned int i, struct lx_timer* timer)
+{
+    heap[i] = timer;
+    timer->heap_idx = i + 1;
+}
+
+static void
+__heap_sift_up(unsigned int i)
+{
+    struct lx_timer** heap = timer_ctx->timers;
+    struct lx_timer* timer = heap[i];
+
+    while (i) {
+        unsigned int parent = (i - 1) / 2;
+        if (!ticks_before(timer->deadline, heap[parent]->deadline)) {
+            break;
+        }
+
+        __heap_place(heap, i, heap[parent]);
+        i = parent;
+    }
+
+    __heap_place(heap, i, timer);
+}
+
+static void
+__heap_sift_down(unsigned int i)
+{
+    struct lx_timer** heap = timer_ctx->timers;
+    struct lx_timer* timer = heap[i];
+    unsigned int len = timer_ctx->nr_timers;
+
+    while (1) {
+        unsigned int child = i * 2 + 1;
+        if (child >= len) {
+            break;
+        }
+
+        if (child + 1 < len &&
+            ticks_before(heap[child + 1]->deadline, heap[child]->deadline)) {
+            child++;
+        }
+
+        if (!ticks_before(heap[child]->deadline, timer->deadline)) {
+            break;
+        }
+
+        __heap_place(heap, i, heap[child]);
+        i = child;
+    }
+
+    __heap_place(heap, i, timer);
+}
+
+static int
+__heap_insert(struct lx_timer* timer)
+{
+    struct lx_timer_context* ctx = (struct lx_timer_context*)timer_ctx;
+
+    if (ctx->nr_timers == ctx->capacity) {
+        struct lx_timer** heap;
+
+        // keep the old heap intact, should we fail to grow
+        heap = vcalloc(sizeof(struct lx_timer*), ctx->capacity * 2);
+        if (!heap) {
+            return ENOMEM;
+        }
+
+        memcpy(heap, ctx->timers, sizeof(struct lx_timer*) * ctx->capacity);
+        vfree(ctx->timers);
+
+        ctx->timers = heap;
+        ctx->capacity *= 2;
+    }
+
+    unsigned int i = ctx->nr_timers++;
+    __heap_place(ctx->timers, i, timer);
+    __heap_sift_up(i);
+
+    return 0;
+}
+
+static void
+__heap_remove(struct lx_timer* timer)
+{
+    struct lx_timer** heap = timer_ctx->timers;
+    unsigned int i = timer->heap_idx - 1;
+    unsigned int last = --timer_ctx->nr_timers;
+
+    timer->heap_idx = 0;
+
+    if (i == last) {
+        return;
+    }
+
+    __heap_place(heap, i, heap[last]);
+
+    if (i && ticks_before(heap[i]->deadline, heap[(i - 1) / 2]->deadline)) {
+        __heap_sift_up(i);
+    } else {
+        __heap_sift_down(i);
+    }
+}
+
 struct lx_timer*
 timer_run_second(u32_t second,
                  void (*callback)(void*),
@@ -86,42 +201,165 @@ timer_run(ticks_t ticks, void (*callback)(void*), void* payload, u8_t flags)
     if (!timer)
         return NULL;
 
-    timer->callback = callback;
-    timer->counter = ticks;
-    timer->deadline = ticks;
-    timer->payload = payload;
-    timer->flags = flags;
+    timer_setup(timer, callback, payload, flags | TIMER_AUTOFREE);
 
-    llist_append(&timer_ctx->active_timers->link, &timer->link);
+    if (timer_arm(timer, ticks)) {
+        cake_release(timer_pile, timer);
+        return NULL;
+    }
 
     return timer;
 }
 
+void
+timer_setup(struct lx_timer* timer,
+            void (*callback)(void*),
+            void* payload,
+            u8_t flags)
+{
+    *timer = (struct lx_timer){ .callback = callback,
+                                .payload = payload,
+                                .flags = flags };
+}
+
+int
+timer_arm(struct lx_timer* timer, ticks_t ticks)
+{
+    if (timer_armed(timer)) {
+        __heap_remove(timer);
+    }
+
+    // a zero-tick timer expires on next tick.
+    ticks = ticks ?: 1;
+
+    timer->interval = ticks;
+    timer->deadline = hwtimer_current_systicks() + ticks;
+
+    return __heap_insert(timer);
+}
+
+void
+timer_disarm(struct lx_timer* timer)
+{
+    if (timer_armed(timer)) {
+        __heap_remove(timer);
+    }
+}
+
+void
+timer_cancel(struct lx_timer* timer)
+{
+    assert(timer->flags & TIMER_AUTOFREE);
+
+    timer_disarm(timer);
+    cake_release(timer_pile, timer);
+}
+
+ticks_t
+timer_remaining(struct lx_timer* timer)
+{
+    if (!timer_armed(timer)) {
+        return 0;
+    }
+
+    ticks_t now = hwtimer_current_systicks();
+    if (!ticks_before(now, timer->deadline)) {
+        return 0;
+    }
+
+    return timer->deadline - now;
+}
+
+bool
+timer_next_deadline(ticks_t* deadline)
+{
+    if (!timer_ctx->nr_timers) {
+        return false;
+    }
+
+    *deadline = timer_ctx->timers[0]->deadline;
+    return true;
+}
+
+void
+timer_idle()
+{
+    ticks_t deadline, now, ticks = TIMER_IDLE_MAX;
+
+    cpu_disable_interrupt();
+
+    // a wakeup might have landed before we got here, and it will not
+    // come again to break the halt.
+    if (sched_nr_ready()) {
+        cpu_enable_interrupt();
+        return;
+    }
+
+    now = hwtimer_current_systicks();
+    if (timer_next_deadline(&deadline)) {
+        if (!ticks_before(now, deadline)) {
+            cpu_enable_interrupt();
+            return;
+        }
+
+        ticks = MIN(deadline - now, ticks);
+    }
+
+    // The next tick will come soon anyway.
+    if (ticks > 1) {
+        hwtimer_oneshot(ticks);
+    }
+
+    cpu_idle();
+
+    cpu_disable_interrupt();
+    hwtimer_resume();
+    cpu_enable_interrupt();
+}
+
 static void
 timer_update()
 {
-    struct lx_timer *pos, *n;
-    struct lx_timer* timer_list_head = timer_ctx->active_timers;
+    struct lx_timer* pos;
+    ticks_t now = hwtimer_current_systicks();
 
-    llist_for_each(pos, n, &timer_list_head->link, link)
-    {
-        if (--(pos->counter)) {
-            continue;
+    clock_tick(now);
+
+    /*
+        Only expired timers are visited. Each is taken off the heap
+        before callback, so callback is free to (re-)arm any timer.
+    */
+    while (timer_ctx->nr_timers) {
+        pos = timer_ctx->timers[0];
+
+        if (ticks_before(now, pos->deadline)) {
+            break;
         }
 
+        __heap_remove(pos);
+
         pos->callback ? pos->callback(pos->payload) : 1;
 
+        if (timer_armed(pos)) {
+            // re-armed by callback
+            continue;
+        }
+
         if ((pos->flags & TIMER_MODE_PERIODIC)) {
-            pos->counter = pos->deadline;
-        } else {
-            llist_delete(&pos->link);
+            // just taken off, thus there is always room
+            pos->deadline += pos->interval;
+            __heap_insert(pos);
+        } else if ((pos->flags & TIMER_AUTOFREE)) {
             cake_release(timer_pile, pos);
         }
     }
 
+    vdso_update(current_thread);
+
     sched_ticks_counter++;
 
-    if (sched_ticks_counter >= sched_ticks) {
+    time_t slice = sched_timeslice(current_thread);
+    if (sched_ticks_counter >= (SYS_TIMER_FREQUENCY_HZ * slice) / 1000) {
         sched_ticks_counter = 0;
         schedule();
     }
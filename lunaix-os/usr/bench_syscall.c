@@ -0,0 +1,72 @@
+#include <lunaix/syscall.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define ROUNDS 10000
+
+static inline unsigned int
+rdtsc()
+{
+    unsigned int lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return lo;
+}
+
+static unsigned int
+vdso_getpid_cost()
+{
+    unsigned int start, end;
+
+    start = rdtsc();
+    for (int i = 0; i < ROUNDS; i++) {
+        getpid();
+    }
+    end = rdtsc();
+
+    return (end - start) / ROUNDS;
+}
+
+static unsigned int
+null_syscall_cost(void (*entry)())
+{
+    unsigned int start, end;
+
+    __lxsys_entry = entry;
+
+    // warm up caches and TLB
+    for (int i = 0; i < ROUNDS / 10; i++) {
+        do_lunaix_syscall(__SYSCALL_getpid);
+    }
+
+    start = rdtsc();
+    for (int i = 0; i < ROUNDS; i++) {
+        do_lunaix_syscall(__SYSCALL_getpid);
+    }
+    end = rdtsc();
+
+    return (end - start) / ROUNDS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    void (*chosen)() = __lxsys_entry;
+    unsigned int int33, sysenter;
+
+    printf("vdso:     %u cycles per getpid\n", vdso_getpid_cost());
+
+    int33 = null_syscall_cost(__lxsys_int33);
+    printf("int 33:   %u cycles per getpid\n", int33);
+
+    if (chosen != __lxsys_sysenter) {
+        printf("sysenter: not supported\n");
+        return 0;
+    }
+
+    sysenter = null_syscall_cost(__lxsys_sysenter);
+    printf("sysenter: %u cycles per getpid (%ux)\n",
+           sysenter,
+           sysenter ? int33 / sysenter : 0);
+
+    return 0;
+}
@@ -2,3 +2,12 @@
 #include <lunaix/dirent_defs.h>
 
 __LXSYSCALL2(int, sys_readdir, int, fd, struct lx_dirent*, dent)
+
+__LXSYSCALL3(int,
+             sys_getdents,
+             int,
+             fd,
+             struct lx_dirent*,
+             dents,
+             unsigned int,
+             count)
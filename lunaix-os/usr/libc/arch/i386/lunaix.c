@@ -10,3 +10,5 @@ __LXSYSCALL3(pid_t, waitpid, pid_t, pid, int*, status, int, options);
 __LXSYSCALL2_VARG(void, syslog, int, level, const char*, fmt);
 
 __LXSYSCALL3(int, realpathat, int, fd, char*, buf, size_t, size)
+
+__LXSYSCALL4(int, futex, int*, uaddr, int, op, int, val, int, timeout)
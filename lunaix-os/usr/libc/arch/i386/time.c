@@ -0,0 +1,4 @@
+#include "syscall.h"
+#include <time.h>
+
+__LXSYSCALL2(int, clock_gettime, int, clockid, struct timespec*, ts)
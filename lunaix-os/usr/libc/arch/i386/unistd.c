@@ -7,8 +7,6 @@ __LXSYSCALL1(int, brk, void*, addr)
 
 __LXSYSCALL1(void*, sbrk, ssize_t, size)
 
-__LXSYSCALL(pid_t, getpid)
-
 __LXSYSCALL(pid_t, getppid)
 
 __LXSYSCALL(pid_t, getpgid)
@@ -23,6 +21,8 @@ __LXSYSCALL(int, pause)
 
 __LXSYSCALL1(unsigned int, alarm, unsigned int, seconds)
 
+__LXSYSCALL1(int, nice, int, inc)
+
 __LXSYSCALL2(int, link, const char*, oldpath, const char*, newpath)
 
 __LXSYSCALL1(int, rmdir, const char*, pathname)
@@ -43,8 +43,14 @@ __LXSYSCALL2(int, dup2, int, oldfd, int, newfd)
 
 __LXSYSCALL1(int, dup, int, oldfd)
 
+__LXSYSCALL1(int, pipe, int*, fds)
+
+__LXSYSCALL2(int, pipe2, int*, fds, int, flags)
+
 __LXSYSCALL1(int, fsync, int, fildes)
 
+__LXSYSCALL2(int, ftruncate, int, fd, off_t, length)
+
 __LXSYSCALL2(int, symlink, const char*, pathname, const char*, link_target)
 
 __LXSYSCALL1(int, chdir, const char*, path)
@@ -3,10 +3,15 @@
 
 #include <lunaix/dirent_defs.h>
 
+// entries fetched from kernel at once
+#define DIR_BATCH 16
+
 typedef struct
 {
     int dirfd;
-    struct lx_dirent _lxd;
+    int _pos;
+    int _len;
+    struct lx_dirent _lxd[DIR_BATCH];
 } DIR;
 
 struct dirent
@@ -27,4 +32,7 @@ readdir(DIR* dir);
 extern int
 sys_readdir(int fd, struct lx_dirent* dirent);
 
+extern int
+sys_getdents(int fd, struct lx_dirent* dirents, unsigned int count);
+
 #endif /* __LUNAIX_DIRENT_H */
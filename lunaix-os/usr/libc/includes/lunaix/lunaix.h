@@ -1,6 +1,7 @@
 #ifndef __LUNAIX_SYS_LUNAIX_H
 #define __LUNAIX_SYS_LUNAIX_H
 
+#include <lunaix/threads.h>
 #include <lunaix/types.h>
 #include <stddef.h>
 
@@ -19,4 +20,20 @@ syslog(int level, const char* fmt, ...);
 int
 realpathat(int fd, char* buf, size_t size);
 
+/**
+ * @brief Milliseconds since boot, read without entering kernel.
+ *
+ */
+unsigned int
+systime();
+
+/**
+ * @brief FUTEX_WAIT: sleep if `*uaddr` still equals `val`, up to `timeout`
+ *        milliseconds, forever if negative. FUTEX_WAKE: wake up to `val`
+ *        waiters on `uaddr`.
+ *
+ */
+int
+futex(int* uaddr, int op, int val, int timeout);
+
 #endif /* __LUNAIX_LUNAIX_H */
@@ -6,4 +6,16 @@
 extern unsigned long 
 do_lunaix_syscall(unsigned long call_id, ...);
 
+/*
+    Syscall entry stubs, __lxsys_entry is the one in use and chosen at
+    startup. Arguments are passed in registers, not for calling from C.
+*/
+extern void (*__lxsys_entry)();
+
+extern void
+__lxsys_int33();
+
+extern void
+__lxsys_sysenter();
+
 #endif /* __LUNAIX_OSDEPS_SYSCALL_H */
@@ -2,6 +2,7 @@
 #define __LUNAIX_PTHREAD_H
 
 #include <lunaix/threads.h>
+#include <time.h>
 
 typedef unsigned int pthread_t;
 
@@ -9,6 +10,42 @@ typedef struct {
     // TODO
 } pthread_attr_t;
 
+/*
+    Locks are plain words in user memory, taken and released with atomic
+    ops. Kernel is entered (futex) only to sleep on a contended word, or
+    to wake somebody sleeping on it.
+*/
+
+typedef struct {
+    int state; // 0: free, 1: locked, 2: locked and contended
+} pthread_mutex_t;
+
+typedef struct {
+    // TODO
+} pthread_mutexattr_t;
+
+typedef struct {
+    int seq; // bumped on every signal
+    int waiters;
+} pthread_cond_t;
+
+typedef struct {
+    // TODO
+} pthread_condattr_t;
+
+typedef struct {
+    int state; // > 0: readers holding, -1: writer holding, 0: free
+    int waiters;
+} pthread_rwlock_t;
+
+typedef struct {
+    // TODO
+} pthread_rwlockattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER { 0 }
+#define PTHREAD_COND_INITIALIZER { 0, 0 }
+#define PTHREAD_RWLOCK_INITIALIZER { 0, 0 }
+
 int 
 pthread_create(pthread_t* thread,
                 const pthread_attr_t* attr,
@@ -28,6 +65,68 @@ pthread_kill(pthread_t thread, int sig);
 
 pthread_t pthread_self(void);
 
+int
+pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr);
+
+int
+pthread_mutex_destroy(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_lock(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_trylock(pthread_mutex_t* mutex);
+
+int
+pthread_mutex_unlock(pthread_mutex_t* mutex);
+
+int
+pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr);
+
+int
+pthread_cond_destroy(pthread_cond_t* cond);
+
+int
+pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+
+/**
+ * @brief Like pthread_cond_wait, but give up at `abstime` (CLOCK_REALTIME)
+ *        with ETIMEDOUT.
+ *
+ */
+int
+pthread_cond_timedwait(pthread_cond_t* cond,
+                       pthread_mutex_t* mutex,
+                       const struct timespec* abstime);
+
+int
+pthread_cond_signal(pthread_cond_t* cond);
+
+int
+pthread_cond_broadcast(pthread_cond_t* cond);
+
+int
+pthread_rwlock_init(pthread_rwlock_t* rwlock,
+                    const pthread_rwlockattr_t* attr);
+
+int
+pthread_rwlock_destroy(pthread_rwlock_t* rwlock);
+
+int
+pthread_rwlock_rdlock(pthread_rwlock_t* rwlock);
+
+int
+pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock);
+
+int
+pthread_rwlock_wrlock(pthread_rwlock_t* rwlock);
+
+int
+pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock);
+
+int
+pthread_rwlock_unlock(pthread_rwlock_t* rwlock);
+
 
 
 #endif /* __LUNAIX_PTHREAD_H */
@@ -0,0 +1,18 @@
+#ifndef __LUNAIX_TIME_H
+#define __LUNAIX_TIME_H
+
+#include <lunaix/time_defs.h>
+
+typedef unsigned int time_t;
+
+/**
+ * @brief Seconds since unix epoch, read without entering kernel.
+ *
+ */
+time_t
+time(time_t* tloc);
+
+int
+clock_gettime(int clockid, struct timespec* ts);
+
+#endif /* __LUNAIX_TIME_H */
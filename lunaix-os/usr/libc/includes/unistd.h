@@ -39,6 +39,15 @@ pause();
 extern unsigned int
 alarm(unsigned int seconds);
 
+/**
+ * @brief Add `inc` to nice value, only a privileged process may decrease it.
+ *
+ * @return the new nice value, which can be negative, thus a failure
+ *         (-1 with EPERM) has to be told by errno.
+ */
+extern int
+nice(int inc);
+
 extern int
 link(const char* oldpath, const char* newpath);
 
@@ -78,9 +87,18 @@ dup2(int oldfd, int newfd);
 extern int
 dup(int oldfd);
 
+extern int
+pipe(int fds[2]);
+
+extern int
+pipe2(int fds[2], int flags);
+
 extern int
 fsync(int fd);
 
+extern int
+ftruncate(int fd, off_t length);
+
 extern int
 symlink(const char* pathname, const char* linktarget);
 
@@ -0,0 +1,9 @@
+#ifndef __LUNAIX__VDSO_H
+#define __LUNAIX__VDSO_H
+
+#include <lunaix/vdso.h>
+
+// set by crt0, NULL if kernel gave none
+extern const volatile struct lx_vdso* __lxvdso;
+
+#endif /* __LUNAIX__VDSO_H */
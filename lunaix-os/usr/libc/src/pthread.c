@@ -1,3 +1,5 @@
+#include "_vdso.h"
+
 #include <lunaix/syscall.h>
 #include <pthread.h>
 
@@ -62,5 +64,9 @@ pthread_kill(pthread_t thread, int sig)
 pthread_t 
 pthread_self(void)
 {
+    if (__lxvdso) {
+        return __lxvdso->tid;
+    }
+
     return do_lunaix_syscall(__SYSCALL_th_self);
 }
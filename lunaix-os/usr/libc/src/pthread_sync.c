@@ -0,0 +1,268 @@
+#include <errno.h>
+#include <lunaix/lunaix.h>
+#include <pthread.h>
+#include <time.h>
+
+#define WAKE_ALL 0x7fffffff
+#define MAX_TIMEOUT_MS 0x7fffffff
+
+#define __load(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+#define __store(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST)
+#define __xchg(ptr, val) __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST)
+#define __add(ptr, val) __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#define __sub(ptr, val) __atomic_sub_fetch(ptr, val, __ATOMIC_SEQ_CST)
+
+static inline int
+__cas(int* ptr, int expected, int desired)
+{
+    __atomic_compare_exchange_n(
+      ptr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+}
+
+/* --- mutex --- */
+
+int
+pthread_mutex_init(pthread_mutex_t* mutex, const pthread_mutexattr_t* attr)
+{
+    // FIXME attr currently not used
+    mutex->state = 0;
+    return 0;
+}
+
+int
+pthread_mutex_destroy(pthread_mutex_t* mutex)
+{
+    return __load(&mutex->state) ? EBUSY : 0;
+}
+
+int
+pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    int c = __cas(&mutex->state, 0, 1);
+    if (!c) {
+        return 0;
+    }
+
+    // mark it contended, so the owner knows to wake us on unlock
+    if (c != 2) {
+        c = __xchg(&mutex->state, 2);
+    }
+
+    while (c) {
+        futex(&mutex->state, FUTEX_WAIT, 2, -1);
+        c = __xchg(&mutex->state, 2);
+    }
+
+    return 0;
+}
+
+int
+pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    return __cas(&mutex->state, 0, 1) ? EBUSY : 0;
+}
+
+int
+pthread_mutex_unlock(pthread_mutex_t* mutex)
+{
+    if (__sub(&mutex->state, 1)) {
+        __store(&mutex->state, 0);
+        futex(&mutex->state, FUTEX_WAKE, 1, -1);
+    }
+
+    return 0;
+}
+
+/* --- condition variable --- */
+
+int
+pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
+{
+    // FIXME attr currently not used
+    cond->seq = 0;
+    cond->waiters = 0;
+    return 0;
+}
+
+int
+pthread_cond_destroy(pthread_cond_t* cond)
+{
+    return __load(&cond->waiters) ? EBUSY : 0;
+}
+
+static int
+__cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, int timeout)
+{
+    int seq, ret = 0;
+
+    // count ourself in before sampling seq, a signaler bumps seq before
+    // looking at waiters, thus one of us always sees the other.
+    __add(&cond->waiters, 1);
+    seq = __load(&cond->seq);
+
+    pthread_mutex_unlock(mutex);
+
+    if (futex(&cond->seq, FUTEX_WAIT, seq, timeout) < 0 &&
+        errno == ETIMEDOUT) {
+        ret = ETIMEDOUT;
+    }
+
+    __sub(&cond->waiters, 1);
+
+    pthread_mutex_lock(mutex);
+    return ret;
+}
+
+int
+pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    return __cond_wait(cond, mutex, -1);
+}
+
+int
+pthread_cond_timedwait(pthread_cond_t* cond,
+                       pthread_mutex_t* mutex,
+                       const struct timespec* abstime)
+{
+    struct timespec now;
+    int sec, nsec;
+
+    if (clock_gettime(CLOCK_REALTIME, &now) < 0) {
+        return EINVAL;
+    }
+
+    sec = (int)(abstime->tv_sec - now.tv_sec);
+    nsec = (int)abstime->tv_nsec - (int)now.tv_nsec;
+
+    if (sec < 0 || (!sec && nsec <= 0)) {
+        return ETIMEDOUT;
+    }
+
+    if (sec >= MAX_TIMEOUT_MS / 1000 - 1) {
+        return __cond_wait(cond, mutex, MAX_TIMEOUT_MS);
+    }
+
+    // round up, never wake before abstime
+    return __cond_wait(cond, mutex, sec * 1000 + (nsec + 999999) / 1000000);
+}
+
+static int
+__cond_wake(pthread_cond_t* cond, int nr)
+{
+    __add(&cond->seq, 1);
+
+    if (__load(&cond->waiters)) {
+        futex(&cond->seq, FUTEX_WAKE, nr, -1);
+    }
+
+    return 0;
+}
+
+int
+pthread_cond_signal(pthread_cond_t* cond)
+{
+    return __cond_wake(cond, 1);
+}
+
+int
+pthread_cond_broadcast(pthread_cond_t* cond)
+{
+    return __cond_wake(cond, WAKE_ALL);
+}
+
+/* --- reader-writer lock --- */
+
+int
+pthread_rwlock_init(pthread_rwlock_t* rwlock,
+                    const pthread_rwlockattr_t* attr)
+{
+    // FIXME attr currently not used
+    rwlock->state = 0;
+    rwlock->waiters = 0;
+    return 0;
+}
+
+int
+pthread_rwlock_destroy(pthread_rwlock_t* rwlock)
+{
+    return __load(&rwlock->state) ? EBUSY : 0;
+}
+
+static inline void
+__rwlock_wait(pthread_rwlock_t* rwlock, int state)
+{
+    __add(&rwlock->waiters, 1);
+    futex(&rwlock->state, FUTEX_WAIT, state, -1);
+    __sub(&rwlock->waiters, 1);
+}
+
+int
+pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock)
+{
+    int s = __load(&rwlock->state);
+
+    while (s >= 0) {
+        int c = __cas(&rwlock->state, s, s + 1);
+        if (c == s) {
+            return 0;
+        }
+        s = c;
+    }
+
+    return EBUSY;
+}
+
+int
+pthread_rwlock_rdlock(pthread_rwlock_t* rwlock)
+{
+    int s;
+
+    while (pthread_rwlock_tryrdlock(rwlock)) {
+        if ((s = __load(&rwlock->state)) < 0) {
+            __rwlock_wait(rwlock, s);
+        }
+    }
+
+    return 0;
+}
+
+int
+pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock)
+{
+    return __cas(&rwlock->state, 0, -1) ? EBUSY : 0;
+}
+
+int
+pthread_rwlock_wrlock(pthread_rwlock_t* rwlock)
+{
+    int s;
+
+    while ((s = __cas(&rwlock->state, 0, -1))) {
+        __rwlock_wait(rwlock, s);
+    }
+
+    return 0;
+}
+
+int
+pthread_rwlock_unlock(pthread_rwlock_t* rwlock)
+{
+    int s = __load(&rwlock->state);
+
+    if (s < 0) {
+        __store(&rwlock->state, 0);
+        s = 0;
+    } else if (s > 0) {
+        s = __sub(&rwlock->state, 1);
+    } else {
+        return EINVAL;
+    }
+
+    // writers and readers share the queue, let them sort it out
+    if (!s && __load(&rwlock->waiters)) {
+        futex(&rwlock->state, FUTEX_WAKE, WAKE_ALL, -1);
+    }
+
+    return 0;
+}
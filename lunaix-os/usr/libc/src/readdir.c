@@ -42,16 +42,20 @@ readdir(DIR* dir)
         return NULL;
     }
 
-    struct lx_dirent* _lxd = &dir->_lxd;
+    if (dir->_pos == dir->_len) {
+        int got = sys_getdents(dir->dirfd, dir->_lxd, DIR_BATCH);
+        if (got <= 0) {
+            return NULL;
+        }
+
+        dir->_pos = 0;
+        dir->_len = got;
+    }
 
-    int more = sys_readdir(dir->dirfd, _lxd);
+    struct lx_dirent* _lxd = &dir->_lxd[dir->_pos++];
 
     _dirent.d_type = _lxd->d_type;
     strncpy(_dirent.d_name, _lxd->d_name, 256);
 
-    if (more) {
-        return &_dirent;
-    }
-
-    return NULL;
+    return &_dirent;
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "_vdso.h"
+
+#include <lunaix/lunaix.h>
+#include <lunaix/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static void
+__vdso_clock(unsigned int* ticks, unsigned int* freq, unsigned int* epoch)
+{
+    unsigned int seq;
+
+    do {
+        while ((seq = __lxvdso->seq) & 1)
+            ;
+
+        *ticks = __lxvdso->systicks;
+        *freq = __lxvdso->tick_freq;
+        *epoch = __lxvdso->epoch;
+    } while (seq != __lxvdso->seq);
+}
+
+pid_t
+getpid()
+{
+    if (!__lxvdso) {
+        return do_lunaix_syscall(__SYSCALL_getpid);
+    }
+
+    return __lxvdso->pid;
+}
+
+unsigned int
+systime()
+{
+    unsigned int ticks, freq, epoch;
+
+    if (!__lxvdso) {
+        return 0;
+    }
+
+    __vdso_clock(&ticks, &freq, &epoch);
+
+    return (ticks / freq) * 1000 + (ticks % freq) * 1000 / freq;
+}
+
+time_t
+time(time_t* tloc)
+{
+    unsigned int ticks, freq, epoch;
+    time_t now = (time_t)-1;
+
+    if (__lxvdso) {
+        __vdso_clock(&ticks, &freq, &epoch);
+        now = epoch + ticks / freq;
+    }
+
+    if (tloc) {
+        *tloc = now;
+    }
+
+    return now;
+}
@@ -9,6 +9,8 @@
 char pwd[512];
 char cat_buf[1024];
 
+#define MAX_STAGES 8
+
 /*
     Simple shell - (actually this is not even a shell)
     It just to make the testing more easy.
@@ -107,6 +109,37 @@ sigint_handle(int signum)
     return;
 }
 
+/*
+    Run `name` in child, with its stdin and stdout replaced by `in` and `out`
+    if they are not -1. `spare` is closed in child, -1 if none.
+*/
+pid_t
+sh_spawn(const char* name, const char** argv, int in, int out, int spare)
+{
+    pid_t p;
+    if (!(p = fork())) {
+        // a pipe end left open here keeps the other side from ever seeing
+        //  EOF or EPIPE
+        if (spare != -1) {
+            close(spare);
+        }
+        if (in != -1) {
+            dup2(in, stdin);
+            close(in);
+        }
+        if (out != -1) {
+            dup2(out, stdout);
+            close(out);
+        }
+        if (execve(name, argv, NULL)) {
+            sh_printerr();
+        }
+        _exit(1);
+    }
+    setpgid(p, getpgid());
+    return p;
+}
+
 void
 sh_exec(const char* name, const char** argv)
 {
@@ -116,15 +149,70 @@ sh_exec(const char* name, const char** argv)
         return;
     }
 
-    pid_t p;
-    if (!(p = fork())) {
-        if (execve(name, argv, NULL)) {
+    pid_t p = sh_spawn(name, argv, -1, -1, -1);
+    waitpid(p, NULL, 0);
+}
+
+/*
+    Run `cmd1 | cmd2 | ...`, each stage reads what the previous one writes.
+*/
+void
+sh_pipeline(char** stages, int n)
+{
+    pid_t pids[MAX_STAGES];
+    char *cmd, *argv[] = { 0, 0 };
+    int fds[2], in = -1, i, nr_pids = 0;
+
+    for (i = 0; i < n; i++) {
+        fds[0] = fds[1] = -1;
+        if (i < n - 1 && pipe(fds)) {
             sh_printerr();
+            break;
         }
-        _exit(1);
+
+        parse_cmdline(stages[i], &cmd, &argv[0]);
+        pids[nr_pids++] =
+          sh_spawn(cmd, (const char**)argv, in, fds[1], fds[0]);
+
+        // child has its copy, ours only keep the pipe open
+        if (in != -1) {
+            close(in);
+        }
+        if (fds[1] != -1) {
+            close(fds[1]);
+        }
+        in = fds[0];
     }
-    setpgid(p, getpgid());
-    waitpid(p, NULL, 0);
+
+    if (in != -1) {
+        close(in);
+    }
+
+    for (i = 0; i < nr_pids; i++) {
+        waitpid(pids[i], NULL, 0);
+    }
+}
+
+int
+split_pipeline(char* line, char** stages)
+{
+    int n = 0;
+
+    stages[n++] = line;
+    for (; *line; line++) {
+        if (*line != '|') {
+            continue;
+        }
+
+        if (n == MAX_STAGES) {
+            return -1;
+        }
+
+        *line = 0;
+        stages[n++] = line + 1;
+    }
+
+    return n;
 }
 
 void
@@ -132,6 +220,8 @@ sh_loop()
 {
     char buf[512];
     char *cmd, *argpart;
+    char* stages[MAX_STAGES];
+    int nr_stages;
     signal(SIGINT, sigint_handle);
 
     // set our shell as foreground process
@@ -153,6 +243,17 @@ sh_loop()
 
         buf[sz] = '\0';
 
+        nr_stages = split_pipeline(buf, stages);
+        if (nr_stages < 0) {
+            printf("Error: too many commands in pipeline\n");
+            goto cont;
+        }
+
+        if (nr_stages > 1) {
+            sh_pipeline(stages, nr_stages);
+            goto cont;
+        }
+
         // currently, this shell only support single argument
         parse_cmdline(buf, &cmd, &argv[0]);
 
@@ -76,6 +76,29 @@ __inc_number(void* value)
     return NULL;
 }
 
+static pthread_mutex_t __counter_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __counter_done = PTHREAD_COND_INITIALIZER;
+static int __finished = 0;
+
+static void* 
+__inc_number_locked(void* value)
+{
+    for (int i = 0; i < 100000; i++)
+    {
+        pthread_mutex_lock(&__counter_lock);
+        __counter_shared++;
+        pthread_mutex_unlock(&__counter_lock);
+    }
+
+    pthread_mutex_lock(&__counter_lock);
+    __finished++;
+    pthread_cond_signal(&__counter_done);
+    pthread_mutex_unlock(&__counter_lock);
+
+    printf("thread %d: exit\n", pthread_self());
+    return NULL;
+}
+
 static void* 
 __spawn_and_quit(void* value)
 {
@@ -157,6 +180,23 @@ pthread_test_shared_race(int param)
     printf("counter val: %ld\n", __counter_shared);
 }
 
+static void
+pthread_test_shared_locked(int param)
+{
+    __counter_shared = 0;
+    __finished = 0;
+
+    spawn_detached_thread(__inc_number_locked, param);
+
+    pthread_mutex_lock(&__counter_lock);
+    while (__finished < param) {
+        pthread_cond_wait(&__counter_done, &__counter_lock);
+    }
+    pthread_mutex_unlock(&__counter_lock);
+
+    printf("counter val: %ld, expect %d\n", __counter_shared, param * 100000);
+}
+
 static void
 pthread_test_quit(int param)
 {
@@ -193,6 +233,10 @@ int main()
     run_test(shared_race, "shared_race10", 10);
     run_test(shared_race, "shared_race40", 40);
 
+    run_test(shared_locked, "shared_locked10", 10);
+    run_test(shared_locked, "shared_locked40", 40);
+
     // TODO test pthread + signal
     printf("All test passed.\n");
+    return 0;
 }
\ No newline at end of file